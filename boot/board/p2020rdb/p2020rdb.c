@@ -105,6 +105,30 @@ unsigned int sysClkFreqGet (void)
     return(sysClkFreq);
     }
 
+/*******************************************************************************
+*
+* sysTimeBaseFreqGet - return the Time Base frequency
+*
+* The Time Base counts once per 8 system bus cycles.  The frequency is
+* computed on the first call only.
+*
+* RETURNS: Time Base ticks per second
+*
+* ERRNO: N/A
+*
+* \NOMANUAL
+*/
+
+unsigned int sysTimeBaseFreqGet (void)
+    {
+    static unsigned int tbFreq = 0;
+
+    if (tbFreq == 0)
+        tbFreq = sysClkFreqGet () >> 3;
+
+    return (tbFreq);
+    }
+
 /*******************************************************************************
 *
 * udelay - delay at least the specified amount of time (in microseconds)
@@ -165,7 +189,7 @@ void udelay
 
     /* add to round up before div to provide "at least" */
 
-    oneUsDelay = (((sysClkFreqGet() >> 3) + 1000000) / 1000000);
+    oneUsDelay = ((sysTimeBaseFreqGet() + 1000000) / 1000000);
 
     /* Convert delay time into ticks */
 
@@ -1,4 +1,5 @@
 #include "ns16550.h"
+#include "diskio.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -11,12 +12,15 @@ extern int boot (unsigned char * imageAddr, unsigned char * dtbAddr);
 extern int cmd_parse(const char * inputLine);
 
 extern void serial_init(NS16550_t console, unsigned int);
+extern int serial_port_init(int port, NS16550_t base, unsigned int clk, unsigned int baud);
 extern void banner(void);
 extern int heap_init(void);
 extern void getcmd(char *);
 extern void sym_table_init(void);
 extern void readid(void);
 extern void sysMiscInit(void);
+extern int init_priv_data(void);
+extern void run_boot_script(void);
 extern unsigned char     binArrayStart [];   /* compressed binary image */
 extern unsigned char     binArrayEnd [];     /* end of compressed binary image */
 extern char etext [];       /* defined by the loader */
@@ -31,6 +35,18 @@ extern void _romInit(void);
 
 const static NS16550_t console = (NS16550_t) (CCSBAR + 0x4500);
 
+/*
+ * FatFs window of the 16MB NOR flash at 0xff000000, clear of the
+ * boot image (last 1MB at 0xfff00000) and the param/script blocks
+ */
+#define NOR_FAT_OFFSET          0x00600000
+#define NOR_FAT_SIZE            0x00800000
+
+/* second DUART channel, serial port 1 for bulk data ("baud -p 1") */
+#define DATA_PORT               1
+#define DATA_PORT_BAUDRATE      115200
+const static NS16550_t data_port = (NS16550_t) (CCSBAR + 0x4600);
+
 void mainboot(void)
     {
     char cmd_buf[MAX_CMDBUF_SIZE];
@@ -39,6 +55,8 @@ void mainboot(void)
     /* ns16550 init */
 
     serial_init(console, (unsigned int)CFG_NS16550_CLK);
+    serial_port_init(DATA_PORT, data_port, (unsigned int)CFG_NS16550_CLK,
+                     DATA_PORT_BAUDRATE);
 
      printf("copy bootloader from(ROM)-0x%x to(RAM)-0x%x size-0x%x\n", \
         0xfff00000, wrs_kernel_text_start,end-wrs_kernel_text_start);
@@ -71,7 +89,18 @@ void mainboot(void)
     //mtd_dev_init();
     cfi_probe_nor_flash();
 
-fat();
+    /* default partition table and parameters, before anything uses them */
+
+    init_priv_data();
+
+    /* FatFs drive 0 is the FAT window of the NOR flash */
+
+    if (nordisk_create(0, NOR_FAT_OFFSET, NOR_FAT_SIZE) != RES_OK)
+        printf("FAT drive 0 (NOR flash) is not available\n");
+
+    /* provisioning and recovery steps, see src/drivers/mtd/script.c */
+
+    run_boot_script();
 
     for (;;)
         {
@@ -83,22 +112,27 @@ fat();
 
         getcmd(cmd_buf);
 
-        /* execute the inputs */
+        /* execute the inputs: single character shortcuts, then commands */
 
-        switch (cmd_buf[0])
+        if (cmd_buf[1] == '\0')
             {
-            case '@':
-                boot((unsigned char *)0x2000000, (unsigned char *)0xf000000);
-                break;
-            case 'g':
-                boot((unsigned char *)0x100000, (unsigned char *)0);
-                break;
-            case 'r':
-                addr = 0x100000;
-                ((void (*)(void)) addr) ();
-                break;
-            default:
-                break;
+            /* a shortcut is not parsed again as a command abbreviation */
+
+            switch (cmd_buf[0])
+                {
+                case '@':
+                    boot((unsigned char *)0x2000000, (unsigned char *)0xf000000);
+                    continue;
+                case 'g':
+                    boot((unsigned char *)0x100000, (unsigned char *)0);
+                    continue;
+                case 'r':
+                    addr = 0x100000;
+                    ((void (*)(void)) addr) ();
+                    continue;
+                default:
+                    break;
+                }
             }
 
         cmd_parse(cmd_buf);
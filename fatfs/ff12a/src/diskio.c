@@ -1,56 +1,75 @@
 /*-----------------------------------------------------------------------*/
-/* Low level disk I/O module skeleton for FatFs     (C)ChaN, 2016        */
+/* Low level disk I/O module for wrboot                 (C)ChaN, 2016    */
 /*-----------------------------------------------------------------------*/
-/* If a working storage control module is available, it should be        */
-/* attached to the FatFs via a glue function rather than modifying it.   */
-/* This is an example of glue functions to attach various exsisting      */
-/* storage control modules to the FatFs module with a defined API.       */
+/* The physical drives are not hard-wired here. Each storage backend     */
+/* (RAM disk, NOR flash, host file) fills a BLKDEV descriptor and        */
+/* registers it to a physical drive number with disk_register(). The     */
+/* functions below only validate the request and dispatch it to the     */
+/* backend of the drive.                                                 */
 /*-----------------------------------------------------------------------*/
 
+#include "ff.h"			/* FatFs configurations and get_fattime() */
 #include "diskio.h"		/* FatFs lower layer API */
 
-/* Definitions of physical drive number for each drive */
-#define DEV_RAM		0	/* Example: Map Ramdisk to physical drive 0 */
-#define DEV_MMC		1	/* Example: Map MMC/SD card to physical drive 1 */
-#define DEV_USB		2	/* Example: Map USB MSD to physical drive 2 */
+
+static BLKDEV* Drive[MAX_DRIVES];	/* Registered block devices */
+
 
 
 /*-----------------------------------------------------------------------*/
-/* Get Drive Status                                                      */
+/* Register/Unregister a Block Device                                    */
 /*-----------------------------------------------------------------------*/
 
-DSTATUS disk_status (
-	BYTE pdrv		/* Physical drive nmuber to identify the drive */
+DRESULT disk_register (
+	BYTE pdrv,		/* Physical drive nmuber to be assigned */
+	BLKDEV* bd		/* Block device descriptor (must be static) */
 )
 {
-	return 0;
-	DSTATUS stat;
-	int result;
-#if 0
-	switch (pdrv) {
-	case DEV_RAM :
-		result = RAM_disk_status();
+	if (pdrv >= MAX_DRIVES || !bd || !bd->read) return RES_PARERR;
+	if (bd->ssize < _MIN_SS || bd->ssize > _MAX_SS || (bd->ssize & (bd->ssize - 1))) return RES_PARERR;
+	if (!bd->n_blk) bd->n_blk = 1;
 
-		// translate the reslut code here
+	bd->stat = STA_NOINIT;
+	if (!bd->write) bd->stat |= STA_PROTECT;
+	Drive[pdrv] = bd;
 
-		return stat;
-	case DEV_MMC :
-		result = MMC_disk_status();
+	return RES_OK;
+}
 
-		// translate the reslut code here
 
-		return stat;
+void disk_unregister (
+	BYTE pdrv		/* Physical drive nmuber to be released */
+)
+{
+	if (pdrv < MAX_DRIVES) {
+		if (Drive[pdrv] && Drive[pdrv]->sync) Drive[pdrv]->sync(Drive[pdrv]);
+		Drive[pdrv] = 0;
+	}
+}
 
-	case DEV_USB :
-		result = USB_disk_status();
 
-		// translate the reslut code here
+BLKDEV* disk_get (
+	BYTE pdrv		/* Physical drive nmuber */
+)
+{
+	return pdrv < MAX_DRIVES ? Drive[pdrv] : 0;
+}
 
-		return stat;
-	}
-#endif
 
-	return STA_NOINIT;
+
+/*-----------------------------------------------------------------------*/
+/* Get Drive Status                                                      */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_status (
+	BYTE pdrv		/* Physical drive nmuber to identify the drive */
+)
+{
+	BLKDEV* bd = disk_get(pdrv);
+
+
+	if (!bd) return STA_NOINIT | STA_NODISK;
+	return bd->stat;
 }
 
 
@@ -63,34 +82,17 @@ DSTATUS disk_initialize (
 	BYTE pdrv				/* Physical drive nmuber to identify the drive */
 )
 {
+	BLKDEV* bd = disk_get(pdrv);
 	DSTATUS stat;
-	int result;
-	return 0;
-#if 0
-	switch (pdrv) {
-	case DEV_RAM :
-		result = RAM_disk_initialize();
-
-		// translate the reslut code here
-
-		return stat;
-
-	case DEV_MMC :
-		result = MMC_disk_initialize();
 
-		// translate the reslut code here
 
-		return stat;
+	if (!bd) return STA_NOINIT | STA_NODISK;
 
-	case DEV_USB :
-		result = USB_disk_initialize();
+	stat = bd->init ? bd->init(bd) : 0;
+	if (!bd->write) stat |= STA_PROTECT;
+	bd->stat = stat;
 
-		// translate the reslut code here
-
-		return stat;
-	}
-	return STA_NOINIT;
-#endif
+	return stat;
 }
 
 
@@ -106,39 +108,14 @@ DRESULT disk_read (
 	UINT count		/* Number of sectors to read */
 )
 {
-	DRESULT res;
-	int result;
-
-	switch (pdrv) {
-	case DEV_RAM :
-		// translate the arguments here
-
-		result = memcpy(buff, (char *)sector, count * 512);
-
-		// translate the reslut code here
-
-		return res;
-#if 0
-	case DEV_MMC :
-		// translate the arguments here
-
-		result = MMC_disk_read(buff, sector, count);
-
-		// translate the reslut code here
+	BLKDEV* bd = disk_get(pdrv);
 
-		return res;
 
-	case DEV_USB :
-		// translate the arguments here
+	if (!bd || !buff || !count) return RES_PARERR;
+	if (bd->stat & STA_NOINIT) return RES_NOTRDY;
+	if (sector >= bd->n_sect || count > bd->n_sect - sector) return RES_PARERR;
 
-		result = USB_disk_read(buff, sector, count);
-
-		// translate the reslut code here
-
-		return res;
-#endif
-	}
-	return RES_PARERR;
+	return bd->read(bd, buff, sector, count);
 }
 
 
@@ -154,40 +131,15 @@ DRESULT disk_write (
 	UINT count			/* Number of sectors to write */
 )
 {
-	DRESULT res;
-	int result;
-
-	switch (pdrv) {
-	case DEV_RAM :
-		// translate the arguments here
-
-		result = memcpy((char *)sector, buff, count * 512);
-
-		// translate the reslut code here
+	BLKDEV* bd = disk_get(pdrv);
 
-		return res;
-#if 0
-	case DEV_MMC :
-		// translate the arguments here
 
-		result = MMC_disk_write(buff, sector, count);
+	if (!bd || !buff || !count) return RES_PARERR;
+	if (bd->stat & STA_NOINIT) return RES_NOTRDY;
+	if (bd->stat & STA_PROTECT) return RES_WRPRT;
+	if (sector >= bd->n_sect || count > bd->n_sect - sector) return RES_PARERR;
 
-		// translate the reslut code here
-
-		return res;
-
-	case DEV_USB :
-		// translate the arguments here
-
-		result = USB_disk_write(buff, sector, count);
-
-		// translate the reslut code here
-
-		return res;
-#endif
-	}
-
-	return RES_PARERR;
+	return bd->write(bd, buff, sector, count);
 }
 
 
@@ -202,34 +154,46 @@ DRESULT disk_ioctl (
 	void *buff		/* Buffer to send/receive control data */
 )
 {
-	DRESULT res;
-	int result;
-
-	switch (pdrv) {
-	case DEV_RAM :
+	BLKDEV* bd = disk_get(pdrv);
 
-		// Process of the command for the RAM drive
 
-		return res;
+	if (!bd) return RES_PARERR;
+	if (bd->stat & STA_NOINIT) return RES_NOTRDY;
 
-	case DEV_MMC :
+	switch (cmd) {
+	case CTRL_SYNC :		/* Flush write-back data of the backend */
+		return bd->sync ? bd->sync(bd) : RES_OK;
 
-		// Process of the command for the MMC/SD card
+	case GET_SECTOR_COUNT :	/* Number of sectors on the drive */
+		*(DWORD*)buff = bd->n_sect;
+		return RES_OK;
 
-		return res;
+	case GET_SECTOR_SIZE :	/* Sector size in byte */
+		*(WORD*)buff = bd->ssize;
+		return RES_OK;
 
-	case DEV_USB :
+	case GET_BLOCK_SIZE :	/* Erase block size in unit of sector */
+		*(DWORD*)buff = bd->n_blk;
+		return RES_OK;
 
-		// Process of the command the USB drive
-
-		return res;
+	case CTRL_TRIM :		/* No backend can make use of the hint */
+		return RES_OK;
 	}
 
 	return RES_PARERR;
 }
 
 
-void get_fattime(void)
+
+/*-----------------------------------------------------------------------*/
+/* Get Current Time                                                      */
+/*-----------------------------------------------------------------------*/
+/* The board has no RTC, so every object is time-stamped with the fixed  */
+/* date given by _NORTC_YEAR/_NORTC_MON/_NORTC_MDAY in ffconf.h.         */
+
+DWORD get_fattime (void)
 {
-	return 1970;
+	return	  ((DWORD)(_NORTC_YEAR - 1980) << 25)
+			| ((DWORD)_NORTC_MON << 21)
+			| ((DWORD)_NORTC_MDAY << 16);
 }
\ No newline at end of file
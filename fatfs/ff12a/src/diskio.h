@@ -36,6 +36,36 @@ DRESULT disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 
 
+/*---------------------------------------*/
+/* Block device registry                 */
+
+#define MAX_DRIVES		4	/* Number of physical drives that can be registered */
+
+typedef struct _BLKDEV BLKDEV;
+
+struct _BLKDEV {
+	const char* name;	/* Device name shown in messages */
+	WORD	ssize;		/* Sector size [byte] */
+	DWORD	n_sect;		/* Number of sectors */
+	DWORD	n_blk;		/* Erase block size [sector] (1:unknown or not a flash) */
+	DSTATUS	stat;		/* Drive status (maintained by diskio.c) */
+	void*	priv;		/* Backend private data */
+	DSTATUS (*init) (BLKDEV* bd);		/* Bring up the device (0:no-op) */
+	DRESULT (*read) (BLKDEV* bd, BYTE* buff, DWORD sector, UINT count);
+	DRESULT (*write) (BLKDEV* bd, const BYTE* buff, DWORD sector, UINT count);	/* 0:read-only */
+	DRESULT (*sync) (BLKDEV* bd);		/* Flush write-back data (0:no-op) */
+};
+
+DRESULT disk_register (BYTE pdrv, BLKDEV* bd);
+void disk_unregister (BYTE pdrv);
+BLKDEV* disk_get (BYTE pdrv);
+
+/* Block device backends */
+DRESULT ramdisk_create (BYTE pdrv, BYTE* base, DWORD n_sect, WORD ssize);
+DRESULT nordisk_create (BYTE pdrv, DWORD ofs, DWORD size);
+DRESULT filedisk_create (BYTE pdrv, const char* path);
+
+
 /* Disk Status Bits (DSTATUS) */
 
 #define STA_NOINIT		0x01	/* Drive not initialized */
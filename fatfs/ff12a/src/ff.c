@@ -72,6 +72,21 @@
 #endif
 
 
+/* Directory lookup cache */
+#if _FS_DIRCACHE & (_FS_DIRCACHE - 1)
+#error Wrong _FS_DIRCACHE setting
+#endif
+
+
+/* Free cluster map */
+#if _FS_FREEMAP > 2
+#error Wrong _FS_FREEMAP setting
+#endif
+#define FM_NONE		0	/* The map is not built */
+#define FM_VALID	1	/* The map is in sync with the FAT */
+#define FM_NOMEM	2	/* No memory for the map on this volume */
+
+
 /* File lock controls */
 #if _FS_LOCK != 0
 #if _FS_READONLY
@@ -567,11 +582,11 @@ static WCHAR LfnBuf[_MAX_LFN+1];	/* LFN enabled with static working buffer */
 #if _FS_EXFAT
 #define	DEF_NAMBUF		WCHAR *lfn;
 #define INIT_NAMBUF(fs)	{ lfn = ff_memalloc((_MAX_LFN+1)*2 + SZDIRE*19); if (!lfn) LEAVE_FF(fs, FR_NOT_ENOUGH_CORE); (fs)->lfnbuf = lfn; (fs)->dirbuf = (BYTE*)(lfn+_MAX_LFN+1); }
-#define	FREE_NAMBUF()	ff_mekfree(lfn)
+#define	FREE_NAMBUF()	ff_memfree(lfn)
 #else
 #define	DEF_NAMBUF		WCHAR *lfn;
 #define INIT_NAMBUF(fs)	{ lfn = ff_memalloc((_MAX_LFN+1)*2); if (!lfn) LEAVE_FF(fs, FR_NOT_ENOUGH_CORE); (fs)->lfnbuf = lfn; }
-#define	FREE_NAMBUF()	ff_mekfree(lfn)
+#define	FREE_NAMBUF()	ff_memfree(lfn)
 #endif
 
 #else
@@ -1108,9 +1123,160 @@ FRESULT put_fat (	/* FR_OK(0):succeeded, !=0:error */
 			break;
 		}
 	}
+#if _FS_FREEMAP
+	if (fs->fmap_stat == FM_VALID) {	/* Reflect the change to the free cluster map */
+		if (res != FR_OK) {
+			fs->fmap_stat = FM_NONE;	/* The map can be out of sync, rebuild it later */
+		} else if (val == 0) {
+			fs->fmap[clst / 8] &= ~(1 << (clst % 8));
+		} else {
+			fs->fmap[clst / 8] |= 1 << (clst % 8);
+		}
+	}
+#endif
 	return res;
 }
 
+
+
+
+
+#if _FS_FREEMAP
+/*-----------------------------------------------------------------------*/
+/* FAT12/16/32: Free cluster map                                         */
+/*-----------------------------------------------------------------------*/
+
+/*---------------------------------------------*/
+/* Build the free cluster map from the FAT     */
+/*---------------------------------------------*/
+
+static
+FRESULT fm_build (	/* FR_OK(0):The map is valid, !=0:The map is not available */
+	FATFS* fs		/* File system object */
+)
+{
+	DWORD clst, sect, nfree, sz, stat;
+	UINT i;
+	BYTE *map, *p;
+	_FDID obj;
+
+
+	if (fs->fmap_stat == FM_VALID) return FR_OK;
+	if (fs->fmap_stat == FM_NOMEM || (_FS_EXFAT && fs->fs_type == FS_EXFAT)) return FR_NOT_ENOUGH_CORE;
+
+	sz = (fs->n_fatent + 7) / 8;
+	if (fs->fmap_size < sz) {	/* Get a buffer for the map (reused on remount) */
+		if (fs->fmap) ff_memfree(fs->fmap);
+		fs->fmap = ff_memalloc(sz);
+		fs->fmap_size = fs->fmap ? sz : 0;
+		if (!fs->fmap) {
+			fs->fmap_stat = FM_NOMEM;
+			return FR_NOT_ENOUGH_CORE;
+		}
+	}
+	map = fs->fmap;
+	mem_set(map, 0, sz);
+	map[0] = 0x03;		/* Cluster #0 and #1 are not allocatable */
+	for (clst = fs->n_fatent; clst < sz * 8; clst++) {	/* Neither are the padding bits */
+		map[clst / 8] |= 1 << (clst % 8);
+	}
+
+	nfree = 0;
+	if (fs->fs_type == FS_FAT12) {	/* FAT12: Sector unaligned FAT entries */
+		clst = 2; obj.fs = fs;
+		do {
+			stat = get_fat(&obj, clst);
+			if (stat == 0xFFFFFFFF) return FR_DISK_ERR;
+			if (stat == 1) return FR_INT_ERR;
+			if (stat == 0) {
+				nfree++;
+			} else {
+				map[clst / 8] |= 1 << (clst % 8);
+			}
+		} while (++clst < fs->n_fatent);
+	} else {						/* FAT16/32: Sector aligned FAT entries */
+		clst = 0; sect = fs->fatbase;
+		i = 0; p = 0;
+		do {
+			if (i == 0) {
+				if (move_window(fs, sect++) != FR_OK) return FR_DISK_ERR;
+				p = fs->win;
+				i = SS(fs);
+			}
+			if (fs->fs_type == FS_FAT16) {
+				stat = ld_word(p);
+				p += 2; i -= 2;
+			} else {
+				stat = ld_dword(p) & 0x0FFFFFFF;
+				p += 4; i -= 4;
+			}
+			if (clst >= 2) {
+				if (stat == 0) {
+					nfree++;
+				} else {
+					map[clst / 8] |= 1 << (clst % 8);
+				}
+			}
+		} while (++clst < fs->n_fatent);
+	}
+
+	if (fs->free_clst != nfree) {	/* Correct the number of free clusters */
+		fs->free_clst = nfree;
+		fs->fsi_flag |= 1;
+	}
+	fs->fmap_stat = FM_VALID;
+	return FR_OK;
+}
+
+
+/*---------------------------------------------*/
+/* Find a contiguous free cluster block        */
+/*---------------------------------------------*/
+
+static
+DWORD fm_find (	/* 0:No free cluster block, 2..:Top of the free cluster block */
+	FATFS* fs,	/* File system object with a valid map */
+	DWORD clst,	/* Cluster number to scan from (next-fit) */
+	DWORD ncl	/* Number of contiguous clusters to find (1..) */
+)
+{
+	BYTE *map = fs->fmap;
+	BYTE bv;
+	DWORD val, scl, ctr, n;
+
+
+	if (clst < 2 || clst >= fs->n_fatent) clst = 2;
+	scl = val = clst; ctr = 0;
+	n = fs->n_fatent - 2;	/* Number of clusters to scan */
+	do {
+		bv = map[val / 8];
+		if (val % 8 == 0 && (bv == 0xFF || (bv == 0 && ncl - ctr > 8))) {	/* Skip 8 clusters at a time */
+			val += 8;
+			n = (n > 8) ? n - 8 : 0;
+			if (bv) {
+				scl = val; ctr = 0;		/* Encountered live clusters, restart the block */
+			} else {
+				ctr += 8;
+			}
+		} else {
+			bv &= 1 << (val % 8);
+			val++; n--;
+			if (!bv) {	/* Is it a free cluster? */
+				if (++ctr == ncl) return scl;	/* Check run length */
+			} else {
+				scl = val; ctr = 0;		/* Encountered a live cluster, restart the block */
+			}
+		}
+		if (val >= fs->n_fatent) {		/* Wrap-around, a block cannot straddle the end */
+			scl = val = 2; ctr = 0;
+		}
+	} while (n);
+
+	return 0;
+}
+
+#endif /* _FS_FREEMAP */
+
 #endif /* !_FS_READONLY */
 
 
@@ -1194,6 +1360,7 @@ FRESULT change_bitmap (
 			} while (bm <<= 1);		/* Next bit */
 			bm = 1;
 		} while (++i < SS(fs));		/* Next byte */
+		i = 0;						/* Top of the next sector */
 	}
 }
 
@@ -1347,6 +1514,12 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 			}
 		}
 	} else
+#endif
+#if _FS_FREEMAP
+	if (fs->fmap_stat == FM_VALID) {	/* At the FAT12/16/32 with the free cluster map */
+		ncl = fm_find(fs, scl + 1, 1);	/* Find a free cluster next to the start cluster */
+		if (ncl == 0) return 0;			/* No free cluster */
+	} else
 #endif
 	{	/* At the FAT12/16/32 */
 		ncl = scl;	/* Start cluster */
@@ -1360,6 +1533,13 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 			if (cs == 0) break;				/* Found a free cluster */
 			if (cs == 1 || cs == 0xFFFFFFFF) return cs;	/* An error occurred */
 			if (ncl == scl) return 0;		/* No free cluster */
+#if _FS_FREEMAP
+			if (fm_build(fs) == FR_OK) {	/* Build the map when the next-fit probe missed */
+				ncl = fm_find(fs, ncl, 1);
+				if (ncl == 0) return 0;		/* No free cluster */
+				break;
+			}
+#endif
 		}
 	}
 
@@ -1374,7 +1554,7 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 
 	if (res == FR_OK) {			/* Update FSINFO if function succeeded. */
 		fs->last_clst = ncl;
-		if (fs->free_clst < fs->n_fatent - 2) fs->free_clst--;
+		if (fs->free_clst <= fs->n_fatent - 2) fs->free_clst--;
 		fs->fsi_flag |= 1;
 	} else {
 		ncl = (res == FR_DISK_ERR) ? 0xFFFFFFFF : 1;	/* Failed. Create error status */
@@ -2158,13 +2338,110 @@ FRESULT dir_read (
 
 
 
+#if _FS_DIRCACHE
+/*-----------------------------------------------------------------------*/
+/* Directory handling - Directory lookup cache                           */
+/*-----------------------------------------------------------------------*/
+/* A slot maps (directory start cluster, name hash) to the location of   */
+/* the entry block. dir_find() only uses it as the place to start the    */
+/* scan and compares the entries as usual, so a stale slot costs a       */
+/* rescan but can never return a wrong entry.                            */
+
+static
+WORD dc_hash_sfn (		/* Hash value of an SFN */
+	const BYTE* sfn		/* SFN in directory entry format (11 bytes) */
+)
+{
+	DWORD h = 0x811C9DC5;
+	UINT i;
+
+	for (i = 0; i < 11; i++) h = (h ^ sfn[i]) * 0x01000193;	/* FNV-1a */
+	return (WORD)(h ^ h >> 16);
+}
+
+
+static
+WORD dc_hash (		/* Hash value of the name to find */
+	DIR* dp			/* Directory object with the file name */
+)
+{
+#if _USE_LFN != 0
+	const WCHAR* lfn = dp->obj.fs->lfnbuf;
+	DWORD h = 0x811C9DC5;
+
+	if ((dp->fn[NSFLAG] & (NS_LOSS | NS_LFN)) && !(dp->fn[NSFLAG] & NS_NOLFN)) {	/* The name can be matched with LFN */
+		while (*lfn) h = (h ^ ff_wtoupper(*lfn++)) * 0x01000193;
+		return (WORD)(h ^ h >> 16);
+	}
+#endif
+	return dc_hash_sfn(dp->fn);
+}
+
+
+static
+DCENT* dc_slot (
+	FATFS* fs,		/* File system object */
+	DWORD sclust,	/* Directory start cluster */
+	WORD hash		/* Hash value of the name */
+)
+{
+	return &fs->dcache[(hash ^ (WORD)(sclust * 40503)) & (_FS_DIRCACHE - 1)];
+}
+
+
+static
+void dc_put (
+	FATFS* fs,		/* File system object */
+	DWORD sclust,	/* Directory start cluster */
+	WORD hash,		/* Hash value of the name */
+	DWORD ofs,		/* Offset of the entry block */
+	DWORD dptr		/* Offset of the SFN entry */
+)
+{
+	DCENT *ce = dc_slot(fs, sclust, hash);
+
+	ce->sclust = sclust; ce->hash = hash; ce->ofs = ofs; ce->dptr = dptr;
+}
+
+
+static
+void dc_drop (		/* Invalidate the slots pointing an entry */
+	FATFS* fs,		/* File system object */
+	DWORD sclust,	/* Directory start cluster */
+	DWORD dptr		/* Offset of the SFN entry */
+)
+{
+	UINT i;
+
+	for (i = 0; i < _FS_DIRCACHE; i++) {
+		if (fs->dcache[i].dptr == dptr && fs->dcache[i].sclust == sclust) fs->dcache[i].dptr = 0xFFFFFFFF;
+	}
+}
+
+
+static
+void dc_clear (
+	FATFS* fs		/* File system object */
+)
+{
+	UINT i;
+
+	for (i = 0; i < _FS_DIRCACHE; i++) fs->dcache[i].dptr = 0xFFFFFFFF;
+}
+
+#endif	/* _FS_DIRCACHE */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
 
 static
-FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
-	DIR* dp			/* Pointer to the directory object with the file name */
+FRESULT dir_scan (	/* FR_OK(0):found, FR_NO_FILE:not found, !=0:error */
+	DIR* dp,		/* Directory object with the file name, pointing the first entry to compare */
+	DWORD end		/* Give up after this offset (0xFFFFFFFF:scan to end of table and fill the cache) */
 )
 {
 	FRESULT res;
@@ -2174,30 +2451,12 @@ FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 	BYTE a, ord, sum;
 #endif
 
-	res = dir_sdi(dp, 0);			/* Rewind directory object */
-	if (res != FR_OK) return res;
-#if _FS_EXFAT
-	if (fs->fs_type == FS_EXFAT) {	/* At the exFAT */
-		BYTE nc;
-		UINT di, ni;
-		WORD hash = xname_sum(fs->lfnbuf);		/* Hash value of the name to find */
-
-		while ((res = dir_read(dp, 0)) == FR_OK) {	/* Read an item */
-			if (ld_word(fs->dirbuf + XDIR_NameHash) != hash) continue;	/* Skip the comparison if hash value mismatched */
-			for (nc = fs->dirbuf[XDIR_NumName], di = SZDIRE * 2, ni = 0; nc; nc--, di += 2, ni++) {	/* Compare the name */
-				if ((di % SZDIRE) == 0) di += 2;
-				if (ff_wtoupper(ld_word(fs->dirbuf + di)) != ff_wtoupper(fs->lfnbuf[ni])) break;
-			}
-			if (nc == 0 && !fs->lfnbuf[ni]) break;	/* Name matched? */
-		}
-		return res;
-	}
-#endif
 	/* At the FAT12/16/32 */
 #if _USE_LFN != 0
 	ord = sum = 0xFF; dp->blk_ofs = 0xFFFFFFFF;	/* Reset LFN sequence */
 #endif
 	do {
+		if (dp->dptr > end) { res = FR_NO_FILE; break; }	/* Passed the cached location */
 		res = move_window(fs, dp->sect);
 		if (res != FR_OK) break;
 		c = dp->dir[DIR_Name];
@@ -2220,12 +2479,22 @@ FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 			} else {					/* An SFN entry is found */
 				if (!ord && sum == sum_sfn(dp->dir)) break;	/* LFN matched? */
 				if (!(dp->fn[NSFLAG] & NS_LOSS) && !mem_cmp(dp->dir, dp->fn, 11)) break;	/* SFN matched? */
+#if _FS_DIRCACHE
+				if (end == 0xFFFFFFFF && dp->blk_ofs == 0xFFFFFFFF) {	/* Cache the passed SFN-only entry */
+					dc_put(fs, dp->obj.sclust, dc_hash_sfn(dp->dir), dp->dptr, dp->dptr);
+				}
+#endif
 				ord = 0xFF; dp->blk_ofs = 0xFFFFFFFF;	/* Reset LFN sequence */
 			}
 		}
 #else		/* Non LFN configuration */
 		dp->obj.attr = dp->dir[DIR_Attr] & AM_MASK;
 		if (!(dp->dir[DIR_Attr] & AM_VOL) && !mem_cmp(dp->dir, dp->fn, 11)) break;	/* Is it a valid entry? */
+#if _FS_DIRCACHE
+		if (end == 0xFFFFFFFF && c != DDEM && !(dp->dir[DIR_Attr] & AM_VOL)) {	/* Cache the passed entry */
+			dc_put(fs, dp->obj.sclust, dc_hash_sfn(dp->dir), dp->dptr, dp->dptr);
+		}
+#endif
 #endif
 		res = dir_next(dp, 0);	/* Next entry */
 	} while (res == FR_OK);
@@ -2234,6 +2503,64 @@ FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 }
 
 
+static
+FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
+	DIR* dp			/* Pointer to the directory object with the file name */
+)
+{
+	FRESULT res;
+	FATFS *fs = dp->obj.fs;
+#if _FS_DIRCACHE
+	DCENT *ce;
+	WORD hash;
+#endif
+
+	res = dir_sdi(dp, 0);			/* Rewind directory object */
+	if (res != FR_OK) return res;
+#if _FS_EXFAT
+	if (fs->fs_type == FS_EXFAT) {	/* At the exFAT */
+		BYTE nc;
+		UINT di, ni;
+		WORD hash = xname_sum(fs->lfnbuf);		/* Hash value of the name to find */
+
+		while ((res = dir_read(dp, 0)) == FR_OK) {	/* Read an item */
+			if (ld_word(fs->dirbuf + XDIR_NameHash) != hash) continue;	/* Skip the comparison if hash value mismatched */
+			for (nc = fs->dirbuf[XDIR_NumName], di = SZDIRE * 2, ni = 0; nc; nc--, di += 2, ni++) {	/* Compare the name */
+				if ((di % SZDIRE) == 0) di += 2;
+				if (ff_wtoupper(ld_word(fs->dirbuf + di)) != ff_wtoupper(fs->lfnbuf[ni])) break;
+			}
+			if (nc == 0 && !fs->lfnbuf[ni]) break;	/* Name matched? */
+		}
+		return res;
+	}
+#endif
+	/* At the FAT12/16/32 */
+#if _FS_DIRCACHE
+	hash = dc_hash(dp);
+	ce = dc_slot(fs, dp->obj.sclust, hash);
+	if (ce->dptr != 0xFFFFFFFF && ce->sclust == dp->obj.sclust && ce->hash == hash) {	/* Cache hit? */
+		res = dir_sdi(dp, ce->ofs);		/* Scan the cached entry block only */
+		if (res == FR_OK) res = dir_scan(dp, ce->dptr);
+		if (res == FR_OK || res == FR_DISK_ERR) return res;
+		ce->dptr = 0xFFFFFFFF;			/* Stale slot */
+		res = dir_sdi(dp, 0);			/* Fall back to a full scan */
+		if (res != FR_OK) return res;
+	}
+	res = dir_scan(dp, 0xFFFFFFFF);
+	if (res == FR_OK) {					/* Remember the location of the found entry */
+#if _USE_LFN != 0
+		dc_put(fs, dp->obj.sclust, hash, dp->blk_ofs != 0xFFFFFFFF ? dp->blk_ofs : dp->dptr, dp->dptr);
+#else
+		dc_put(fs, dp->obj.sclust, hash, dp->dptr, dp->dptr);
+#endif
+	}
+	return res;
+#else
+	return dir_scan(dp, 0xFFFFFFFF);
+#endif
+}
+
+
 
 
 #if !_FS_READONLY
@@ -2248,6 +2575,9 @@ FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too many S
 {
 	FRESULT res;
 	FATFS *fs = dp->obj.fs;
+#if _FS_DIRCACHE
+	DWORD ofs = 0xFFFFFFFF;
+#endif
 #if _USE_LFN != 0	/* LFN configuration */
 	UINT n, nlen, nent;
 	BYTE sn[12], sum;
@@ -2265,7 +2595,7 @@ FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too many S
 		if (res != FR_OK) return res;
 		dp->blk_ofs = dp->dptr - SZDIRE * (nent - 1);			/* Set block position */
 
-		if (dp->obj.stat & 4) {			/* Has the sub-directory been stretched? */
+		if (dp->obj.sclust != 0 && (dp->obj.stat & 4)) {	/* Has the sub-directory been stretched? (the root has no entry) */
 			dp->obj.stat &= 3;
 			dp->obj.objsize += (DWORD)fs->csize * SS(fs);	/* Increase object size by cluster size */
 			res = fill_fat_chain(&dp->obj);	/* Complement FAT chain if needed */
@@ -2303,6 +2633,9 @@ FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too many S
 	if (res == FR_OK && --nent) {	/* Set LFN entry if needed */
 		res = dir_sdi(dp, dp->dptr - nent * SZDIRE);
 		if (res == FR_OK) {
+#if _FS_DIRCACHE
+			ofs = dp->dptr;			/* Top of the entry block */
+#endif
 			sum = sum_sfn(dp->fn);	/* Checksum value of the SFN tied to the LFN */
 			do {					/* Store LFN entries in bottom first */
 				res = move_window(fs, dp->sect);
@@ -2329,6 +2662,9 @@ FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too many S
 			dp->dir[DIR_NTres] = dp->fn[NSFLAG] & (NS_BODY | NS_EXT);	/* Put NT flag */
 #endif
 			fs->wflag = 1;
+#if _FS_DIRCACHE
+			dc_put(fs, dp->obj.sclust, dc_hash(dp), ofs != 0xFFFFFFFF ? ofs : dp->dptr, dp->dptr);	/* Replace the slot of the name */
+#endif
 		}
 	}
 
@@ -2353,7 +2689,12 @@ FRESULT dir_remove (	/* FR_OK:Succeeded, FR_DISK_ERR:A disk error */
 	FATFS *fs = dp->obj.fs;
 #if _USE_LFN != 0	/* LFN configuration */
 	DWORD last = dp->dptr;
+#endif
 
+#if _FS_DIRCACHE
+	dc_drop(fs, dp->obj.sclust, dp->dptr);	/* Forget the location of the entry */
+#endif
+#if _USE_LFN != 0	/* LFN configuration */
 	res = (dp->blk_ofs == 0xFFFFFFFF) ? FR_OK : dir_sdi(dp, dp->blk_ofs);	/* Goto top of the entry block if LFN is exist */
 	if (res == FR_OK) {
 		do {
@@ -3137,6 +3478,15 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 
 	fs->fs_type = fmt;	/* FAT sub-type */
 	fs->id = ++Fsid;	/* File system mount ID */
+#if _FS_DIRCACHE
+	dc_clear(fs);		/* Discard the directory lookup cache */
+#endif
+#if !_FS_READONLY && _FS_FREEMAP
+	fs->fmap_stat = FM_NONE;	/* Discard the free cluster map */
+#if _FS_FREEMAP == 2
+	fm_build(fs);		/* Build it now, or on the first allocation if failed */
+#endif
+#endif
 #if _USE_LFN == 1
 	fs->lfnbuf = LfnBuf;	/* Static LFN working buffer */
 #if _FS_EXFAT
@@ -3219,10 +3569,23 @@ FRESULT f_mount (
 		if (!ff_del_syncobj(cfs->sobj)) return FR_INT_ERR;
 #endif
 		cfs->fs_type = 0;				/* Clear old fs object */
+#if !_FS_READONLY && _FS_FREEMAP
+		cfs->fmap_stat = FM_NONE;		/* The free cluster map is rebuilt on next use */
+		if (cfs != fs) {				/* Release the map unless the object is remounted */
+			if (cfs->fmap) ff_memfree(cfs->fmap);
+			cfs->fmap = 0; cfs->fmap_size = 0;
+		}
+#endif
 	}
 
 	if (fs) {
 		fs->fs_type = 0;				/* Clear new fs object */
+#if !_FS_READONLY && _FS_FREEMAP
+		if (fs != cfs) {				/* A remounted object keeps its map buffer */
+			fs->fmap = 0; fs->fmap_size = 0;
+		}
+		fs->fmap_stat = FM_NONE;
+#endif
 #if _FS_REENTRANT						/* Create sync object for the new volume */
 		if (!ff_cre_syncobj((BYTE)vol, &fs->sobj)) return FR_INT_ERR;
 #endif
@@ -3456,6 +3819,9 @@ FRESULT f_read (
 	FSIZE_t remain;
 	UINT rcnt, cc, csect;
 	BYTE *rbuff = (BYTE*)buff;
+#if _FS_EXFAT
+	DWORD ccl, lcl;
+#endif
 
 
 	*br = 0;	/* Clear read byte counter */
@@ -3491,12 +3857,24 @@ FRESULT f_read (
 			sect += csect;
 			cc = btr / SS(fs);					/* When remaining bytes >= sector size, */
 			if (cc) {							/* Read maximum contiguous sectors directly */
+#if _FS_EXFAT
+				ccl = fp->clust - fp->obj.sclust;	/* Cluster offset of current cluster */
+				lcl = (fp->obj.stat == 2) ? (DWORD)((fp->obj.objsize - 1) / SS(fs) / fs->csize) : fp->obj.n_cont;	/* Last cluster of the contiguous part */
+				if (fs->fs_type == FS_EXFAT && (fp->obj.stat == 2 || fp->obj.stat == 3) && ccl <= lcl) {	/* In the contiguous part? */
+					if (cc > (lcl - ccl + 1) * fs->csize - csect) {	/* Clip at end of the contiguous part */
+						cc = (lcl - ccl + 1) * fs->csize - csect;
+					}
+				} else
+#endif
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
 					cc = fs->csize - csect;
 				}
 				if (disk_read(fs->drv, rbuff, sect, cc) != RES_OK) {
 					ABORT(fs, FR_DISK_ERR);
 				}
+#if _FS_EXFAT
+				fp->clust += (csect + cc - 1) / fs->csize;	/* Move to the cluster of the last sector read */
+#endif
 #if !_FS_READONLY && _FS_MINIMIZE <= 2			/* Replace one of the read sectors with cached data if it contains a dirty sector */
 #if _FS_TINY
 				if (fs->wflag && fs->winsect - sect < cc) {
@@ -3567,8 +3945,7 @@ FRESULT f_write (
 	if (!(fp->flag & FA_WRITE)) LEAVE_FF(fs, FR_DENIED);	/* Check access mode */
 
 	/* Check fptr wrap-around (file size cannot exceed the limit on each FAT specs) */
-	if ((_FS_EXFAT && fs->fs_type == FS_EXFAT && fp->fptr + btw < fp->fptr)
-		|| (DWORD)fp->fptr + btw < (DWORD)fp->fptr) {
+	if ((!_FS_EXFAT || fs->fs_type != FS_EXFAT) && (DWORD)(fp->fptr + btw) < (DWORD)fp->fptr) {
 		btw = (UINT)(0xFFFFFFFF - (DWORD)fp->fptr);
 	}
 
@@ -4008,6 +4385,9 @@ FRESULT f_lseek (
 
 	/* Normal Seek */
 	{
+#if _FS_EXFAT
+		if (fs->fs_type != FS_EXFAT && ofs >= 0x100000000) ofs = 0xFFFFFFFF;	/* Clip at 4GiB-1 if at FATxx */
+#endif
 		if (ofs > fp->obj.objsize && (_FS_READONLY || !(fp->flag & FA_WRITE))) {	/* In read-only mode, clip offset with the file size */
 			ofs = fp->obj.objsize;
 		}
@@ -4336,6 +4716,10 @@ FRESULT f_getfree (
 		/* If free_clst is valid, return it without full cluster scan */
 		if (fs->free_clst <= fs->n_fatent - 2) {
 			*nclst = fs->free_clst;
+#if _FS_FREEMAP
+		} else if (fs->fmap_stat != FM_VALID && fm_build(fs) == FR_OK) {
+			*nclst = fs->free_clst;	/* Building the map counts free clusters */
+#endif
 		} else {
 			/* Get number of free clusters */
 			nfree = 0;
@@ -5086,18 +5470,26 @@ FRESULT f_expand (
 	} else
 #endif
 	{
-		scl = clst = stcl; ncl = 0;
-		for (;;) {	/* Find a contiguous cluster block */
-			n = get_fat(&fp->obj, clst);
-			if (++clst >= fs->n_fatent) clst = 2;
-			if (n == 1) { res = FR_INT_ERR; break; }
-			if (n == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
-			if (n == 0) {	/* Is it a free cluster? */
-				if (++ncl == tcl) break;	/* Break if a contiguous cluster block is found */
-			} else {
-				scl = clst; ncl = 0;		/* Not a free cluster */
+#if _FS_FREEMAP
+		if (fm_build(fs) == FR_OK) {
+			scl = fm_find(fs, stcl, tcl);	/* Find a contiguous cluster block on the map */
+			if (scl == 0) res = FR_DENIED;	/* No contiguous cluster block was found */
+		} else
+#endif
+		{
+			scl = clst = stcl; ncl = 0;
+			for (;;) {	/* Find a contiguous cluster block */
+				n = get_fat(&fp->obj, clst);
+				if (++clst >= fs->n_fatent) clst = 2;
+				if (n == 1) { res = FR_INT_ERR; break; }
+				if (n == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
+				if (n == 0) {	/* Is it a free cluster? */
+					if (++ncl == tcl) break;	/* Break if a contiguous cluster block is found */
+				} else {
+					scl = clst; ncl = 0;		/* Not a free cluster */
+				}
+				if (clst == stcl) { res = FR_DENIED; break; }	/* No contiguous cluster? */
 			}
-			if (clst == stcl) { res = FR_DENIED; break; }	/* No contiguous cluster? */
 		}
 		if (res == FR_OK) {
 			if (opt) {
@@ -5114,6 +5506,10 @@ FRESULT f_expand (
 
 	if (opt && res == FR_OK) {
 		fs->last_clst = lclst;		/* Set suggested start cluster to start next */
+		if (fs->free_clst <= fs->n_fatent - 2) {	/* Update FSINFO */
+			fs->free_clst -= lclst - scl + 1;
+			fs->fsi_flag |= 1;
+		}
 		fp->obj.sclust = scl;		/* Update object allocation information */
 		fp->obj.objsize = fsz;
 		if (_FS_EXFAT) fp->obj.stat = 2;	/* Set status 'contiguous chain' */
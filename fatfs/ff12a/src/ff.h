@@ -87,6 +87,19 @@ typedef DWORD FSIZE_t;
 
 
 
+/* Directory lookup cache slot */
+
+#if _FS_DIRCACHE
+typedef struct {
+	DWORD	sclust;		/* Directory start cluster (0:root) */
+	DWORD	ofs;		/* Offset of the entry block (top LFN entry or SFN entry) */
+	DWORD	dptr;		/* Offset of the SFN entry (0xFFFFFFFF:empty slot) */
+	WORD	hash;		/* Hash value of the name */
+} DCENT;
+#endif
+
+
+
 /* File system object structure (FATFS) */
 
 typedef struct {
@@ -113,6 +126,11 @@ typedef struct {
 #if !_FS_READONLY
 	DWORD	last_clst;		/* Last allocated cluster */
 	DWORD	free_clst;		/* Number of free clusters */
+#if _FS_FREEMAP
+	BYTE*	fmap;			/* Free cluster map (a bit per cluster, 1:in use) */
+	DWORD	fmap_size;		/* Size of the fmap[] buffer [byte] */
+	BYTE	fmap_stat;		/* Free cluster map status (0:not built, 1:valid, 2:no memory) */
+#endif
 #endif
 #if _FS_RPATH != 0
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
@@ -129,6 +147,9 @@ typedef struct {
 	DWORD	dirbase;		/* Root directory base sector/cluster */
 	DWORD	database;		/* Data base sector */
 	DWORD	winsect;		/* Current sector appearing in the win[] */
+#if _FS_DIRCACHE
+	DCENT	dcache[_FS_DIRCACHE];	/* Directory lookup cache */
+#endif
 	BYTE	win[_MAX_SS];	/* Disk access window for Directory, FAT (and file data at tiny cfg) */
 } FATFS;
 
@@ -305,10 +326,12 @@ DWORD get_fattime (void);
 #if _USE_LFN != 0						/* Unicode - OEM code conversion */
 WCHAR ff_convert (WCHAR chr, UINT dir);	/* OEM-Unicode bidirectional conversion */
 WCHAR ff_wtoupper (WCHAR chr);			/* Unicode upper-case conversion */
-#if _USE_LFN == 3						/* Memory functions */
-void* ff_memalloc (UINT msize);			/* Allocate memory block */
-void ff_mekfree (void* mblock);			/* Free memory block */
 #endif
+
+/* Memory functions */
+#if _USE_LFN == 3 || (_FS_FREEMAP && !_FS_READONLY)
+void* ff_memalloc (UINT msize);			/* Allocate memory block */
+void ff_memfree (void* mblock);			/* Free memory block */
 #endif
 
 /* Sync functions */
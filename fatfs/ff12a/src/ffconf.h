@@ -39,7 +39,7 @@
 /  f_findnext(). (0:Disable, 1:Enable 2:Enable with matching altname[] too) */
 
 
-#define	_USE_MKFS		0
+#define	_USE_MKFS		1
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
@@ -47,7 +47,7 @@
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
-#define	_USE_EXPAND		0
+#define	_USE_EXPAND		1
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
@@ -69,7 +69,7 @@
 / Locale and Namespace Configurations
 /---------------------------------------------------------------------------*/
 
-#define _CODE_PAGE	932
+#define _CODE_PAGE	437
 /* This option specifies the OEM code page to be used on the target system.
 /  Incorrect setting of the code page can cause a file open failure.
 /
@@ -98,7 +98,7 @@
 */
 
 
-#define	_USE_LFN	0
+#define	_USE_LFN	1
 #define	_MAX_LFN	255
 /* The _USE_LFN switches the support of long file name (LFN).
 /
@@ -113,7 +113,7 @@
 /  It should be set 255 to support full featured LFN operations.
 /  When use stack for the working buffer, take care on stack overflow. When use heap
 /  memory for the working buffer, memory management functions, ff_memalloc() and
-/  ff_mekfree(), must be added to the project. */
+/  ff_memfree(), must be added to the project. */
 
 
 #define	_LFN_UNICODE	0
@@ -209,7 +209,27 @@
 /  buffer in the file system object (FATFS) is used for the file data transfer. */
 
 
-#define _FS_EXFAT	0
+#define _FS_DIRCACHE	128
+/* This option sets the number of slots of the directory lookup cache kept in
+/  each file system object. (0:Disable or power of 2)
+/  The cache maps a (directory, file name) pair to the location of the directory
+/  entry so that opening files in a large directory does not scan the directory
+/  table from the top each time. Each slot takes 16 bytes in the FATFS. */
+
+
+#define _FS_FREEMAP	1
+/* This option switches the free cluster map on the FAT12/16/32 volume.
+/
+/   0: Disable free cluster map.
+/   1: Build the map when an allocation finds the next cluster in use.
+/   2: Build the map when the volume is mounted.
+/
+/  The map holds one bit per cluster in the heap, allocated with ff_memalloc(),
+/  so that cluster allocation, f_getfree() and f_expand() do not scan the FAT.
+/  It is kept in sync with the FAT. This option has no effect at read-only cfg. */
+
+
+#define _FS_EXFAT	1
 /* This option switches support of exFAT file system in addition to the traditional
 /  FAT file system. (0:Disable or 1:Enable) To enable exFAT, also LFN must be enabled.
 /  Note that enabling exFAT discards C89 compatibility. */
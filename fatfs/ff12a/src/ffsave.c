@@ -0,0 +1,192 @@
+/*-----------------------------------------------------------------------*/
+/* Saving memory to files on the boot loader FAT volume                  */
+/*-----------------------------------------------------------------------*/
+/* Memory dumps and downloaded images are large and written once, so the */
+/* file is preallocated as a contiguous cluster block with f_expand()    */
+/* and the data goes to the data area with multi-sector disk_write()     */
+/* calls. Neither the FAT nor the sector buffer of the file object is    */
+/* touched while streaming. If the volume has no contiguous block large  */
+/* enough, the file is written with f_write() as usual.                  */
+/*-----------------------------------------------------------------------*/
+
+#include <string.h>
+#include <stdio.h>
+#include "ff.h"
+#include "diskio.h"
+#include "ffsave.h"
+
+
+static FATFS SaveFs;		/* File system object of the save volume */
+static BYTE Tail[_MAX_SS];	/* Last partial sector of the file */
+static BYTE DumpUsed[(SAVE_NDUMP + 7) / 8];	/* DUMPnnnn.BIN names in use */
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Mount the save volume unless it is still mounted                      */
+/*-----------------------------------------------------------------------*/
+
+static FRESULT save_mount (void)
+{
+	if (SaveFs.fs_type) return FR_OK;	/* Cleared when drive 0 is remounted */
+	return f_mount(&SaveFs, "", 1);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Get the number of a DUMPnnnn.BIN file name                            */
+/*-----------------------------------------------------------------------*/
+
+static int dump_number (	/* Returns nnnn, -1 if it is not a dump file name */
+	const TCHAR* fn			/* Pointer to the file name */
+)
+{
+	static const char pat[] = "DUMP####.BIN";
+	int i, n = 0;
+	TCHAR c;
+
+
+	for (i = 0; pat[i]; i++) {
+		c = fn[i];
+		if (pat[i] == '#') {
+			if (c < '0' || c > '9') return -1;
+			n = n * 10 + c - '0';
+		} else {
+			if (c >= 'a' && c <= 'z') c -= 0x20;
+			if (c != pat[i]) return -1;
+		}
+	}
+
+	return fn[i] ? -1 : n;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write a memory block to a file                                        */
+/*-----------------------------------------------------------------------*/
+
+FRESULT ff_save (
+	const TCHAR* path,	/* Pointer to the file name */
+	const BYTE* buff,	/* Pointer to the data to be saved */
+	DWORD len			/* Number of bytes to save */
+)
+{
+	FRESULT res, rc;
+	FATFS* fs;
+	FIL fil;
+	DWORD sect, nsect;
+	UINT cnt, bw;
+
+
+	res = f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE);
+	if (res != FR_OK) return res;
+
+	if (len) {
+		res = f_expand(&fil, len, 1);	/* Allocate a contiguous cluster block */
+		if (res == FR_OK) {				/* Stream the data to the block */
+			fs = fil.obj.fs;
+			sect = fs->database + fs->csize * (fil.obj.sclust - 2);
+			for (nsect = len / _MAX_SS; nsect && res == FR_OK; nsect -= cnt) {
+				cnt = (nsect > SAVE_CHUNK) ? SAVE_CHUNK : (UINT)nsect;
+				if (disk_write(fs->drv, buff, sect, cnt) != RES_OK) res = FR_DISK_ERR;
+				buff += cnt * _MAX_SS; sect += cnt;
+			}
+			if (res == FR_OK && len % _MAX_SS) {	/* Pad the last sector */
+				memset(Tail, 0, _MAX_SS);
+				memcpy(Tail, buff, len % _MAX_SS);
+				if (disk_write(fs->drv, Tail, sect, 1) != RES_OK) res = FR_DISK_ERR;
+			}
+		} else if (res == FR_DENIED) {	/* No contiguous block, allocate clusters as written */
+			res = f_write(&fil, buff, len, &bw);
+			if (res == FR_OK && bw != len) res = FR_DENIED;	/* Volume full */
+		}
+	}
+
+	rc = f_close(&fil);		/* Write the directory entry and flush the device */
+	if (res == FR_OK) res = rc;
+	if (res != FR_OK) f_unlink(path);	/* Do not leave a broken file */
+
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Shell command: save a memory block to the next DUMPnnnn.BIN           */
+/*-----------------------------------------------------------------------*/
+
+int fsave (
+	unsigned long addr,	/* Start address of the memory block */
+	unsigned long len	/* Number of bytes to save */
+)
+{
+	FRESULT res;
+	DIR dir;
+	FILINFO fno;
+	char path[16];
+	int i;
+
+
+	if (!len) {
+		printf("usage: fsave <addr> <len>\n");
+		return -1;
+	}
+	res = save_mount();
+	if (res != FR_OK) {
+		printf("fsave: cannot mount the volume (%d)\n", res);
+		return -1;
+	}
+
+	memset(DumpUsed, 0, sizeof DumpUsed);	/* Collect the dump names in one directory pass */
+	res = f_opendir(&dir, "");
+	while (res == FR_OK) {
+		res = f_readdir(&dir, &fno);
+		if (res != FR_OK || !fno.fname[0]) break;
+		i = dump_number(fno.fname);
+		if (i >= 0) DumpUsed[i / 8] |= 1 << (i % 8);
+	}
+	f_closedir(&dir);
+	for (i = 0; i < SAVE_NDUMP && (DumpUsed[i / 8] & (1 << (i % 8))); i++) ;	/* Lowest unused number */
+	if (res != FR_OK || i == SAVE_NDUMP) {
+		printf("fsave: no file name available (%d)\n", res);
+		return -1;
+	}
+	sprintf(path, "DUMP%04d.BIN", i);
+
+	printf("fsave: 0x%08lx-0x%08lx -> %s\n", addr, addr + len - 1, path);
+	res = ff_save(path, (const BYTE*)addr, len);
+	if (res != FR_OK) {
+		printf("fsave: failed (%d)\n", res);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Load a file to memory                                                 */
+/*-----------------------------------------------------------------------*/
+
+long fload (			/* Returns number of bytes loaded, -1 on error */
+	const char* path,	/* Pointer to the file name */
+	unsigned long addr,	/* Load address */
+	unsigned long size	/* Size of the memory block at addr */
+)
+{
+	FRESULT res;
+	FIL fil;
+	UINT br;
+
+
+	if (save_mount() != FR_OK) return -1;
+	res = f_open(&fil, path, FA_READ);
+	if (res != FR_OK) return -1;
+	res = f_read(&fil, (void*)addr, size, &br);
+	f_close(&fil);
+
+	return (res == FR_OK) ? (long)br : -1;
+}
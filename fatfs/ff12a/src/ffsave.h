@@ -0,0 +1,17 @@
+/*-----------------------------------------------------------------------/
+/  Saving memory to files on the boot loader FAT volume                  /
+/-----------------------------------------------------------------------*/
+
+#ifndef _FFSAVE_DEFINED
+#define _FFSAVE_DEFINED
+
+#include "ff.h"
+
+#define SAVE_CHUNK	2048	/* Max number of sectors per disk_write of ff_save() */
+#define SAVE_NDUMP	10000	/* Number of DUMPnnnn.BIN names for fsave */
+
+FRESULT ff_save (const TCHAR* path, const BYTE* buff, DWORD len);
+int fsave (unsigned long addr, unsigned long len);
+long fload (const char* path, unsigned long addr, unsigned long size);
+
+#endif /* _FFSAVE_DEFINED */
@@ -0,0 +1,109 @@
+/*-----------------------------------------------------------------------*/
+/* Host file backend for the FatFs block device layer                    */
+/*-----------------------------------------------------------------------*/
+/* Maps a disk image file to a physical drive so that the FatFs module   */
+/* can be run and tested on a development host. It needs a hosted C      */
+/* library and is compiled only when _DISKIO_FILE is defined to 1.       */
+/*-----------------------------------------------------------------------*/
+
+#if _DISKIO_FILE
+
+#include <stdio.h>
+#include "ff.h"
+#include "diskio.h"
+
+
+static BLKDEV FileDisk[MAX_DRIVES];
+
+
+
+static DRESULT file_read (
+	BLKDEV* bd,			/* File disk */
+	BYTE* buff,			/* Data buffer to store read data */
+	DWORD sector,		/* Start sector */
+	UINT count			/* Number of sectors to read */
+)
+{
+	FILE* fp = bd->priv;
+
+
+	if (fseek(fp, (long)sector * bd->ssize, SEEK_SET)) return RES_ERROR;
+	if (fread(buff, bd->ssize, count, fp) != count) return RES_ERROR;
+
+	return RES_OK;
+}
+
+
+
+static DRESULT file_write (
+	BLKDEV* bd,			/* File disk */
+	const BYTE* buff,	/* Data to be written */
+	DWORD sector,		/* Start sector */
+	UINT count			/* Number of sectors to write */
+)
+{
+	FILE* fp = bd->priv;
+
+
+	if (fseek(fp, (long)sector * bd->ssize, SEEK_SET)) return RES_ERROR;
+	if (fwrite(buff, bd->ssize, count, fp) != count) return RES_ERROR;
+
+	return RES_OK;
+}
+
+
+
+static DRESULT file_sync (
+	BLKDEV* bd
+)
+{
+	return fflush((FILE*)bd->priv) ? RES_ERROR : RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Attach a disk image file to a physical drive                          */
+/*-----------------------------------------------------------------------*/
+
+DRESULT filedisk_create (
+	BYTE pdrv,			/* Physical drive nmuber */
+	const char* path	/* Path name of the disk image */
+)
+{
+	BLKDEV* bd;
+	FILE* fp;
+	long sz;
+	int ro = 0;
+
+
+	if (pdrv >= MAX_DRIVES || !path) return RES_PARERR;
+
+	fp = fopen(path, "r+b");
+	if (!fp) {		/* Fall back to a write-protected drive */
+		fp = fopen(path, "rb");
+		if (!fp) return RES_NOTRDY;
+		ro = 1;
+	}
+	if (fseek(fp, 0, SEEK_END) || (sz = ftell(fp)) < _MAX_SS) {
+		fclose(fp);
+		return RES_PARERR;
+	}
+
+	disk_unregister(pdrv);
+	bd = &FileDisk[pdrv];
+	if (bd->priv) fclose(bd->priv);
+	bd->name = path;
+	bd->ssize = _MAX_SS;
+	bd->n_sect = (DWORD)(sz / _MAX_SS);
+	bd->n_blk = 1;
+	bd->priv = fp;
+	bd->init = 0;
+	bd->read = file_read;
+	bd->write = ro ? 0 : file_write;
+	bd->sync = file_sync;
+
+	return disk_register(pdrv, bd);
+}
+
+#endif /* _DISKIO_FILE */
@@ -0,0 +1,217 @@
+/*-----------------------------------------------------------------------*/
+/* NOR flash backend for the FatFs block device layer                    */
+/*-----------------------------------------------------------------------*/
+/* The disk is a window of the CFI flash registered as the MTD device    */
+/* (mymtd). Sectors are much smaller than erase blocks, so writes go to  */
+/* a one-block write-back buffer. The buffered block is erased and       */
+/* programmed when another block is written, or on CTRL_SYNC. Reads of   */
+/* the buffered block are served from the buffer.                        */
+/*-----------------------------------------------------------------------*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "ff.h"
+#include "diskio.h"
+#include "mtd.h"
+
+
+#define NOBLK	0xFFFFFFFF	/* No erase block is buffered */
+
+typedef struct {
+	struct mtd_info* mtd;	/* Underlying MTD device */
+	DWORD	base;			/* Offset of the disk in the MTD */
+	DWORD	cblk;			/* MTD offset of the buffered erase block */
+	DWORD	csize;			/* Size of the buffered erase block */
+	BYTE	dirty;			/* The buffer has been modified */
+	BYTE*	cbuf;			/* Erase block buffer (largest erase size) */
+} NORDISK;
+
+extern struct mtd_info *mymtd;
+
+static BLKDEV NorDisk[MAX_DRIVES];
+static NORDISK NorPriv[MAX_DRIVES];
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write back the buffered erase block                                   */
+/*-----------------------------------------------------------------------*/
+
+static DRESULT nor_flush (
+	NORDISK* nd
+)
+{
+	struct mtd_info* mtd = nd->mtd;
+	struct erase_info ei;
+	size_t rl;
+
+
+	if (nd->cblk == NOBLK || !nd->dirty) return RES_OK;
+
+	memset(&ei, 0, sizeof ei);
+	ei.mtd = mtd;
+	ei.addr = nd->cblk;
+	ei.len = nd->csize;
+	if (mtd->erase(mtd, &ei)) return RES_ERROR;
+	if (mtd->write(mtd, nd->cblk, nd->csize, &rl, nd->cbuf) || rl != nd->csize) return RES_ERROR;
+	nd->dirty = 0;
+
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Block device operations                                               */
+/*-----------------------------------------------------------------------*/
+
+static DSTATUS nor_init (
+	BLKDEV* bd
+)
+{
+	NORDISK* nd = bd->priv;
+	struct mtd_info* mtd = nd->mtd;
+	DWORD sz = mtd->erasesize;
+	int i;
+
+
+	if (nd->cbuf) return 0;
+
+	for (i = 0; i < mtd->numeraseregions; i++) {
+		if (mtd->eraseregions[i].erasesize > sz) sz = mtd->eraseregions[i].erasesize;
+	}
+	nd->cbuf = kmalloc(sz);
+	if (!nd->cbuf) return STA_NOINIT;
+	nd->cblk = NOBLK;
+	nd->dirty = 0;
+
+	return 0;
+}
+
+
+
+static DRESULT nor_read (
+	BLKDEV* bd,			/* NOR disk */
+	BYTE* buff,			/* Data buffer to store read data */
+	DWORD sector,		/* Start sector */
+	UINT count			/* Number of sectors to read */
+)
+{
+	NORDISK* nd = bd->priv;
+	struct mtd_info* mtd = nd->mtd;
+	DWORD ofs = nd->base + sector * bd->ssize;
+	DWORD len = (DWORD)count * bd->ssize;
+	DWORD n;
+	size_t rl;
+
+
+	/* Read the disk directly except the part in the buffered erase block */
+	while (len) {
+		if (nd->cblk != NOBLK && ofs >= nd->cblk && ofs - nd->cblk < nd->csize) {
+			n = nd->cblk + nd->csize - ofs;
+			if (n > len) n = len;
+			memcpy(buff, nd->cbuf + (ofs - nd->cblk), n);
+		} else {
+			n = len;
+			if (nd->cblk != NOBLK && ofs < nd->cblk && nd->cblk - ofs < n) n = nd->cblk - ofs;
+			if (mtd->read(mtd, ofs, n, &rl, buff) || rl != n) return RES_ERROR;
+		}
+		buff += n; ofs += n; len -= n;
+	}
+
+	return RES_OK;
+}
+
+
+
+static DRESULT nor_write (
+	BLKDEV* bd,			/* NOR disk */
+	const BYTE* buff,	/* Data to be written */
+	DWORD sector,		/* Start sector */
+	UINT count			/* Number of sectors to write */
+)
+{
+	NORDISK* nd = bd->priv;
+	struct mtd_info* mtd = nd->mtd;
+	DWORD ofs = nd->base + sector * bd->ssize;
+	DWORD len = (DWORD)count * bd->ssize;
+	u_int32_t blk, bs;
+	DWORD n;
+	size_t rl;
+
+
+	while (len) {
+		if (mtd_block(mtd, ofs, &blk, &bs) < 0) return RES_ERROR;
+		n = blk + bs - ofs;
+		if (n > len) n = len;
+		if (blk != nd->cblk) {		/* Switch the buffered erase block */
+			if (nor_flush(nd) != RES_OK) return RES_ERROR;
+			nd->cblk = NOBLK;
+			if (n < bs) {	/* Partial block update needs the current contents */
+				if (mtd->read(mtd, blk, bs, &rl, nd->cbuf) || rl != bs) return RES_ERROR;
+			}
+			nd->cblk = blk; nd->csize = bs;
+		}
+		memcpy(nd->cbuf + (ofs - blk), buff, n);
+		nd->dirty = 1;
+		buff += n; ofs += n; len -= n;
+	}
+
+	return RES_OK;
+}
+
+
+
+static DRESULT nor_sync (
+	BLKDEV* bd
+)
+{
+	return nor_flush(bd->priv);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Attach a window of the NOR flash to a physical drive                  */
+/*-----------------------------------------------------------------------*/
+
+DRESULT nordisk_create (
+	BYTE pdrv,		/* Physical drive nmuber */
+	DWORD ofs,		/* Offset of the disk in the flash */
+	DWORD size		/* Size of the disk [byte] (0:up to the end of the flash) */
+)
+{
+	BLKDEV* bd;
+	NORDISK* nd;
+
+
+	if (pdrv >= MAX_DRIVES) return RES_PARERR;
+	if (!mymtd || !mymtd->read || !mymtd->write || !mymtd->erase) {
+		printf("nordisk: no MTD device\n");
+		return RES_NOTRDY;
+	}
+	if (ofs >= mymtd->size) return RES_PARERR;
+	if (!size || size > mymtd->size - ofs) size = mymtd->size - ofs;
+
+	disk_unregister(pdrv);		/* Write back the previous disk on this drive */
+	nd = &NorPriv[pdrv];
+	if (nd->cbuf) kfree(nd->cbuf);
+	memset(nd, 0, sizeof *nd);
+	nd->mtd = mymtd;
+	nd->base = ofs;
+	nd->cblk = NOBLK;
+
+	bd = &NorDisk[pdrv];
+	bd->name = "nor";
+	bd->ssize = _MAX_SS;
+	bd->n_sect = size / _MAX_SS;
+	bd->n_blk = mymtd->erasesize / _MAX_SS;
+	bd->priv = nd;
+	bd->init = nor_init;
+	bd->read = nor_read;
+	bd->write = nor_write;
+	bd->sync = nor_sync;
+
+	return disk_register(pdrv, bd);
+}
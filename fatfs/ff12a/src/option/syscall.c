@@ -141,7 +141,7 @@ void* ff_memalloc (	/* Returns pointer to the allocated memory block */
 /* Free a memory block                                                    */
 /*------------------------------------------------------------------------*/
 
-void ff_mekfree (
+void ff_memfree (
 	void* mblock	/* Pointer to the memory block to free */
 )
 {
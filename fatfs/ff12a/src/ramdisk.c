@@ -0,0 +1,73 @@
+/*-----------------------------------------------------------------------*/
+/* RAM disk backend for the FatFs block device layer                     */
+/*-----------------------------------------------------------------------*/
+/* A RAM disk is a plain memory window, e.g. a FAT image downloaded to   */
+/* DDR. Reads and writes are straight memory copies.                     */
+/*-----------------------------------------------------------------------*/
+
+#include <string.h>
+#include "ff.h"
+#include "diskio.h"
+
+
+static BLKDEV RamDisk[MAX_DRIVES];
+
+
+
+static DRESULT ram_read (
+	BLKDEV* bd,			/* RAM disk */
+	BYTE* buff,			/* Data buffer to store read data */
+	DWORD sector,		/* Start sector */
+	UINT count			/* Number of sectors to read */
+)
+{
+	memcpy(buff, (BYTE*)bd->priv + sector * bd->ssize, (size_t)count * bd->ssize);
+
+	return RES_OK;
+}
+
+
+
+static DRESULT ram_write (
+	BLKDEV* bd,			/* RAM disk */
+	const BYTE* buff,	/* Data to be written */
+	DWORD sector,		/* Start sector */
+	UINT count			/* Number of sectors to write */
+)
+{
+	memcpy((BYTE*)bd->priv + sector * bd->ssize, buff, (size_t)count * bd->ssize);
+
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Attach a memory window to a physical drive                            */
+/*-----------------------------------------------------------------------*/
+
+DRESULT ramdisk_create (
+	BYTE pdrv,		/* Physical drive nmuber */
+	BYTE* base,		/* Start address of the disk image */
+	DWORD n_sect,	/* Number of sectors */
+	WORD ssize		/* Sector size [byte] */
+)
+{
+	BLKDEV* bd;
+
+
+	if (pdrv >= MAX_DRIVES || !base || !n_sect) return RES_PARERR;
+
+	bd = &RamDisk[pdrv];
+	bd->name = "ram";
+	bd->ssize = ssize;
+	bd->n_sect = n_sect;
+	bd->n_blk = 1;
+	bd->priv = base;
+	bd->init = 0;
+	bd->read = ram_read;
+	bd->write = ram_write;
+	bd->sync = 0;
+
+	return disk_register(pdrv, bd);
+}
@@ -0,0 +1,46 @@
+/*------------------------------------------------------------------------*/
+/* OS dependent controls for FatFs on the boot loader                     */
+/*------------------------------------------------------------------------*/
+/* The working buffers of the FatFs module are taken from the boot loader */
+/* heap. The host build (_DISKIO_FILE) uses the C library heap instead.   */
+/*------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "ff.h"
+
+
+#if _USE_LFN == 3 || (_FS_FREEMAP && !_FS_READONLY)
+/*------------------------------------------------------------------------*/
+/* Allocate a memory block                                                */
+/*------------------------------------------------------------------------*/
+/* If a NULL is returned, the file function fails with FR_NOT_ENOUGH_CORE.
+*/
+
+void* ff_memalloc (	/* Returns pointer to the allocated memory block */
+	UINT msize		/* Number of bytes to allocate */
+)
+{
+#if _DISKIO_FILE
+	return malloc(msize);
+#else
+	return kmalloc(msize);
+#endif
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Free a memory block                                                    */
+/*------------------------------------------------------------------------*/
+
+void ff_memfree (
+	void* mblock	/* Pointer to the memory block to free */
+)
+{
+#if _DISKIO_FILE
+	free(mblock);
+#else
+	kfree(mblock);
+#endif
+}
+
+#endif
@@ -0,0 +1,482 @@
+/*------------------------------------------------------------------------/
+/  FatFs benchmark and regression bench for Linux hosts
+/-------------------------------------------------------------------------/
+/
+/  Runs the ff12a module of the boot loader against a disk image file and
+/  replays a set of workloads on a freshly formatted volume:
+/
+/   seq   - large sequential write and read of one file
+/   small - many small files in one directory
+/   deep  - deep directory tree, files opened by full path
+/   frag  - interleaved appends and deletes, then reads of the
+/           fragmented files
+/   save  - memory image saved with one f_write() and with ff_save()
+/           (contiguous preallocation and direct sector writes)
+/
+/  Each phase reports ops/s, MB/s and the number of disk_read/disk_write
+/  calls and bytes seen by the block device. The volume is remounted before
+/  every read phase, so the FATFS window starts cold.
+/
+/-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ff.h"
+#include "diskio.h"
+#include "ffsave.h"
+
+
+#define	SZ_CHUNK	32768	/* f_read/f_write transfer size of the seq workload */
+#define SMALL_FILES	500		/* Number of files of the small workload */
+#define SMALL_SIZE	1024	/* Size of each file of the small workload */
+#define DEEP_LEVELS	32		/* Directory depth of the deep workload */
+#define FRAG_FILES	64		/* Number of files of the frag workload */
+#define FRAG_ROUNDS	32		/* Clusters appended to each file */
+
+
+/*---------------------------------------------------------*/
+/* Work Area                                               */
+/*---------------------------------------------------------*/
+
+static FATFS FatFs;			/* File system object */
+static FIL File[2];			/* File objects */
+static BYTE Buff[SZ_CHUNK];	/* Data transfer buffer */
+static BYTE Work[4096];		/* Working buffer of f_mkfs */
+
+static const char* ImagePath = "ffbench.img";
+static DWORD ImageMB = 64;	/* Size of the disk image [MiB] */
+static DWORD AuSize = 0;	/* Cluster size of f_mkfs [byte] (0:auto) */
+static BYTE MkfsOpt = FM_ANY;
+static DWORD SeqMB = 16;	/* File size of the seq workload [MiB] */
+
+
+/* Block device call counters */
+
+static struct {
+	DWORD rd_calls, rd_sect;
+	DWORD wr_calls, wr_sect;
+} Cnt;
+
+static DRESULT (*dev_read) (BLKDEV*, BYTE*, DWORD, UINT);
+static DRESULT (*dev_write) (BLKDEV*, const BYTE*, DWORD, UINT);
+
+static DRESULT cnt_read (BLKDEV* bd, BYTE* buff, DWORD sector, UINT count)
+{
+	Cnt.rd_calls++; Cnt.rd_sect += count;
+	return dev_read(bd, buff, sector, count);
+}
+
+static DRESULT cnt_write (BLKDEV* bd, const BYTE* buff, DWORD sector, UINT count)
+{
+	Cnt.wr_calls++; Cnt.wr_sect += count;
+	return dev_write(bd, buff, sector, count);
+}
+
+
+
+/*---------------------------------------------------------*/
+/* Phase Measurement                                       */
+/*---------------------------------------------------------*/
+
+static double T0;
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void begin (void)
+{
+	memset(&Cnt, 0, sizeof Cnt);
+	T0 = now();
+}
+
+
+static void report (
+	const char* name,	/* Phase name */
+	DWORD ops,			/* Number of operations done in the phase */
+	double bytes		/* Number of file data bytes transferred (0:n/a) */
+)
+{
+	double sec = now() - T0;
+
+	if (sec <= 0) sec = 1e-9;
+	printf("%-12s %8u %9.4f %11.1f ", name, (unsigned)ops, sec, ops / sec);
+	if (bytes > 0) {
+		printf("%9.2f", bytes / sec / 1048576);
+	} else {
+		printf("%9s", "-");
+	}
+	printf(" %9u %10u %9u %10u\n",
+		(unsigned)Cnt.rd_calls, (unsigned)Cnt.rd_sect * (_MAX_SS / 512) / 2,
+		(unsigned)Cnt.wr_calls, (unsigned)Cnt.wr_sect * (_MAX_SS / 512) / 2);
+}
+
+
+static void die (const char* what, FRESULT res)
+{
+	fprintf(stderr, "%s failed (FRESULT %d)\n", what, (int)res);
+	exit(2);
+}
+
+
+
+/*---------------------------------------------------------*/
+/* Volume Management                                       */
+/*---------------------------------------------------------*/
+
+static void create_image (void)
+{
+	FILE* fp;
+	BLKDEV* bd;
+	FRESULT res;
+
+
+	fp = fopen(ImagePath, "wb");
+	if (!fp || fseek(fp, (long)ImageMB * 1048576 - 1, SEEK_SET) || fputc(0, fp) == EOF) {
+		fprintf(stderr, "cannot create %s\n", ImagePath);
+		exit(2);
+	}
+	fclose(fp);
+
+	if (filedisk_create(0, ImagePath) != RES_OK) {
+		fprintf(stderr, "cannot attach %s\n", ImagePath);
+		exit(2);
+	}
+
+	/* Hook the block device to count the calls */
+	bd = disk_get(0);
+	dev_read = bd->read; dev_write = bd->write;
+	bd->read = cnt_read; bd->write = cnt_write;
+
+	res = f_mkfs("", MkfsOpt, AuSize, Work, sizeof Work);
+	if (res != FR_OK) die("f_mkfs", res);
+}
+
+
+static void remount (void)
+{
+	FRESULT res;
+
+	f_mount(0, "", 0);
+	res = f_mount(&FatFs, "", 1);
+	if (res != FR_OK) die("f_mount", res);
+}
+
+
+static DWORD cluster_bytes (void)
+{
+	return (DWORD)FatFs.csize * _MAX_SS;
+}
+
+
+
+/*---------------------------------------------------------*/
+/* Workloads                                               */
+/*---------------------------------------------------------*/
+
+static void wl_seq (void)
+{
+	DWORD n, total = SeqMB * 1048576;
+	UINT bw, br;
+	FRESULT res;
+
+
+	for (n = 0; n < SZ_CHUNK; n++) Buff[n] = (BYTE)n;
+
+	begin();
+	res = f_open(&File[0], "SEQ.BIN", FA_CREATE_ALWAYS | FA_WRITE);
+	if (res != FR_OK) die("f_open", res);
+	for (n = 0; n < total; n += bw) {
+		res = f_write(&File[0], Buff, SZ_CHUNK, &bw);
+		if (res != FR_OK || bw != SZ_CHUNK) die("f_write", res);
+	}
+	f_close(&File[0]);
+	report("seq-write", total / SZ_CHUNK, total);
+
+	remount();
+	begin();
+	res = f_open(&File[0], "SEQ.BIN", FA_READ);
+	if (res != FR_OK) die("f_open", res);
+	for (n = 0; n < total; n += br) {
+		res = f_read(&File[0], Buff, SZ_CHUNK, &br);
+		if (res != FR_OK || br != SZ_CHUNK) die("f_read", res);
+	}
+	f_close(&File[0]);
+	report("seq-read", total / SZ_CHUNK, total);
+}
+
+
+static void wl_small (void)
+{
+	char path[32];
+	DWORD i;
+	UINT bw, br;
+	FRESULT res;
+
+
+	begin();
+	res = f_mkdir("SMALL");
+	if (res != FR_OK) die("f_mkdir", res);
+	for (i = 0; i < SMALL_FILES; i++) {
+		sprintf(path, "SMALL/F%05u.TXT", (unsigned)i);
+		res = f_open(&File[0], path, FA_CREATE_NEW | FA_WRITE);
+		if (res != FR_OK) die("f_open", res);
+		res = f_write(&File[0], Buff, SMALL_SIZE, &bw);
+		if (res != FR_OK || bw != SMALL_SIZE) die("f_write", res);
+		f_close(&File[0]);
+	}
+	report("small-create", SMALL_FILES, (double)SMALL_FILES * SMALL_SIZE);
+
+	remount();
+	begin();
+	for (i = 0; i < SMALL_FILES; i++) {		/* Open in reverse order to defeat a lucky scan */
+		sprintf(path, "SMALL/F%05u.TXT", (unsigned)(SMALL_FILES - 1 - i));
+		res = f_open(&File[0], path, FA_READ);
+		if (res != FR_OK) die("f_open", res);
+		res = f_read(&File[0], Buff, SMALL_SIZE, &br);
+		if (res != FR_OK || br != SMALL_SIZE) die("f_read", res);
+		f_close(&File[0]);
+	}
+	report("small-read", SMALL_FILES, (double)SMALL_FILES * SMALL_SIZE);
+}
+
+
+static void wl_deep (void)
+{
+	char path[DEEP_LEVELS * 4 + 16];
+	FILINFO fno;
+	UINT i, len, bw;
+	FRESULT res;
+
+
+	begin();
+	for (i = len = 0; i < DEEP_LEVELS; i++) {
+		len += sprintf(path + len, "%sD%02u", i ? "/" : "", i);
+		res = f_mkdir(path);
+		if (res != FR_OK) die("f_mkdir", res);
+		strcpy(path + len, "/FILE.TXT");
+		res = f_open(&File[0], path, FA_CREATE_NEW | FA_WRITE);
+		if (res != FR_OK) die("f_open", res);
+		f_write(&File[0], path, len, &bw);
+		f_close(&File[0]);
+		path[len] = 0;
+	}
+	report("deep-create", DEEP_LEVELS * 2, 0);
+
+	remount();
+	begin();
+	for (i = len = 0; i < DEEP_LEVELS; i++) {
+		len += sprintf(path + len, "%sD%02u", i ? "/" : "", i);
+		strcpy(path + len, "/FILE.TXT");
+		res = f_stat(path, &fno);
+		if (res != FR_OK) die("f_stat", res);
+		res = f_open(&File[0], path, FA_READ);
+		if (res != FR_OK) die("f_open", res);
+		f_close(&File[0]);
+		path[len] = 0;
+	}
+	report("deep-open", DEEP_LEVELS * 2, 0);
+}
+
+
+static void wl_frag (void)
+{
+	char path[16];
+	DWORD csz = cluster_bytes(), chunk, total;
+	UINT i, r, bw, br;
+	FRESULT res;
+
+
+	chunk = csz < SZ_CHUNK ? csz : SZ_CHUNK;
+
+	/* Append one cluster to each file in turn so that the chains interleave */
+	begin();
+	for (i = 0; i < FRAG_FILES; i++) {
+		sprintf(path, "FR%02u.BIN", i);
+		res = f_open(&File[0], path, FA_CREATE_NEW | FA_WRITE);
+		if (res != FR_OK) die("f_open", res);
+		f_close(&File[0]);
+	}
+	for (r = 0; r < FRAG_ROUNDS; r++) {
+		for (i = 0; i < FRAG_FILES; i++) {
+			sprintf(path, "FR%02u.BIN", i);
+			res = f_open(&File[0], path, FA_OPEN_APPEND | FA_WRITE);
+			if (res != FR_OK) die("f_open", res);
+			res = f_write(&File[0], Buff, chunk, &bw);
+			if (res != FR_OK || bw != chunk) die("f_write", res);
+			f_close(&File[0]);
+		}
+	}
+	/* Punch holes and fill them with a file that is fragmented all over */
+	for (i = 0; i < FRAG_FILES; i += 2) {
+		sprintf(path, "FR%02u.BIN", i);
+		res = f_unlink(path);
+		if (res != FR_OK) die("f_unlink", res);
+	}
+	total = (DWORD)(FRAG_FILES / 2) * FRAG_ROUNDS * chunk;
+	res = f_open(&File[1], "FRAG.BIN", FA_CREATE_ALWAYS | FA_WRITE);
+	if (res != FR_OK) die("f_open", res);
+	for (r = 0; r < total; r += bw) {
+		res = f_write(&File[1], Buff, chunk, &bw);
+		if (res != FR_OK || bw != chunk) die("f_write", res);
+	}
+	f_close(&File[1]);
+	report("frag-build", FRAG_FILES * FRAG_ROUNDS + total / chunk, (double)total * 2);
+
+	remount();
+	begin();
+	res = f_open(&File[1], "FRAG.BIN", FA_READ);
+	if (res != FR_OK) die("f_open", res);
+	for (r = 0; r < total; r += br) {
+		res = f_read(&File[1], Buff, SZ_CHUNK, &br);
+		if (res != FR_OK || !br) die("f_read", res);
+	}
+	f_close(&File[1]);
+	report("frag-read", total / SZ_CHUNK, total);
+
+	/* Seek around in a fragmented file */
+	begin();
+	res = f_open(&File[0], "FR01.BIN", FA_READ);
+	if (res != FR_OK) die("f_open", res);
+	for (r = 0; r < FRAG_ROUNDS; r++) {
+		res = f_lseek(&File[0], (FSIZE_t)((r * 7) % FRAG_ROUNDS) * chunk);
+		if (res != FR_OK) die("f_lseek", res);
+		res = f_read(&File[0], Buff, 512, &br);
+		if (res != FR_OK || br != 512) die("f_read", res);
+	}
+	f_close(&File[0]);
+	report("frag-seek", FRAG_ROUNDS, (double)FRAG_ROUNDS * 512);
+}
+
+
+
+static void wl_save (void)
+{
+	DWORD n, total = SeqMB * 1048576 + 100;	/* Odd size to cover the last partial sector */
+	BYTE* mem;
+	UINT bw, br;
+	FRESULT res;
+
+
+	mem = malloc(total);
+	if (!mem) die("malloc", FR_NOT_ENOUGH_CORE);
+	for (n = 0; n < total; n++) mem[n] = (BYTE)(n * 7 + n / 4096);
+
+	begin();
+	res = f_open(&File[0], "SAVEW.BIN", FA_CREATE_ALWAYS | FA_WRITE);
+	if (res != FR_OK) die("f_open", res);
+	res = f_write(&File[0], mem, total, &bw);
+	if (res != FR_OK || bw != total) die("f_write", res);
+	f_close(&File[0]);
+	report("save-fwrite", 1, total);
+
+	begin();
+	res = ff_save("SAVEE.BIN", mem, total);
+	if (res != FR_OK) die("ff_save", res);
+	report("save-expand", 1, total);
+
+	remount();
+	begin();
+	res = f_open(&File[0], "SAVEE.BIN", FA_READ);
+	if (res != FR_OK) die("f_open", res);
+	if (f_size(&File[0]) != total) die("f_size", FR_INT_ERR);
+	for (n = 0; n < total; n += br) {
+		res = f_read(&File[0], Buff, SZ_CHUNK, &br);
+		if (res != FR_OK || !br) die("f_read", res);
+		if (memcmp(Buff, mem + n, br)) die("verify", FR_INT_ERR);
+	}
+	f_close(&File[0]);
+	report("save-verify", total / SZ_CHUNK, total);
+	free(mem);
+}
+
+
+
+/*---------------------------------------------------------*/
+/* Main                                                    */
+/*---------------------------------------------------------*/
+
+static const struct {
+	const char* name;
+	void (*func)(void);
+} Workload[] = {
+	{ "seq",	wl_seq },
+	{ "small",	wl_small },
+	{ "deep",	wl_deep },
+	{ "frag",	wl_frag },
+	{ "save",	wl_save },
+	{ 0, 0 }
+};
+
+
+static void usage (void)
+{
+	fprintf(stderr,
+		"usage: ffbench [-i image] [-s image_MiB] [-a au_bytes] [-t fat|fat32|exfat]\n"
+		"               [-m seq_MiB] [workload ...]\n"
+		"workloads: seq small deep frag save (default: all)\n");
+	exit(1);
+}
+
+
+int main (int argc, char* argv[])
+{
+	int i, j, nsel = 0;
+	char sel[8] = {0};
+	DWORD nclst;
+	FATFS* fs;
+
+
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] == '-' && i + 1 < argc) {
+			switch (argv[i][1]) {
+			case 'i': ImagePath = argv[++i]; break;
+			case 's': ImageMB = strtoul(argv[++i], 0, 0); break;
+			case 'a': AuSize = strtoul(argv[++i], 0, 0); break;
+			case 'm': SeqMB = strtoul(argv[++i], 0, 0); break;
+			case 't':
+				i++;
+				if (!strcmp(argv[i], "fat")) MkfsOpt = FM_FAT;
+				else if (!strcmp(argv[i], "fat32")) MkfsOpt = FM_FAT32;
+				else if (!strcmp(argv[i], "exfat")) MkfsOpt = FM_EXFAT;
+				else usage();
+				break;
+			default: usage();
+			}
+			continue;
+		}
+		for (j = 0; Workload[j].name && strcmp(Workload[j].name, argv[i]); j++) ;
+		if (!Workload[j].name) usage();
+		sel[j] = 1; nsel++;
+	}
+
+	create_image();
+	remount();
+	printf("%s: %u MiB, %s, %u bytes/cluster\n", ImagePath, (unsigned)ImageMB,
+		FatFs.fs_type == FS_FAT12 ? "FAT12" : FatFs.fs_type == FS_FAT16 ? "FAT16" :
+		FatFs.fs_type == FS_FAT32 ? "FAT32" : "exFAT",
+		(unsigned)cluster_bytes());
+	printf("%-12s %8s %9s %11s %9s %9s %10s %9s %10s\n",
+		"phase", "ops", "sec", "ops/s", "MB/s", "rd_calls", "rd_KiB", "wr_calls", "wr_KiB");
+
+	for (j = 0; Workload[j].name; j++) {
+		if (nsel && !sel[j]) continue;
+		remount();
+		Workload[j].func();
+	}
+
+	if (f_getfree("", &nclst, &fs) == FR_OK) {
+		printf("free: %u clusters\n", (unsigned)nclst);
+	}
+	f_mount(0, "", 0);
+	disk_unregister(0);
+
+	return 0;
+}
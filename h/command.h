@@ -22,24 +22,52 @@ enum ParseState stackedState;
 typedef struct user_command {
     const char *name;
     void (*cmdfunc)(int argc, const char **);
-    struct user_command *next_cmd;
+    struct user_command *next_cmd;      /* command hash chain */
     const char *helpstr;
 } user_command_t;
 
+/*
+ * Commands are registered at link time: USER_CMD() places the descriptor
+ * in the .wrboot_cmd section, which the linker script collects between
+ * wrboot_cmd_start and wrboot_cmd_end.  The descriptor must stay global,
+ * the top Makefile forces every .wrboot_cmd symbol of the libraries into
+ * the link.
+ *
+ *   USER_CMD(boot_cmd) = { "boot", command_boot, NULL, "boot ..." };
+ */
+#define USER_CMD_SECTION    ".wrboot_cmd"
+#define USER_CMD(var) \
+    user_command_t var __attribute__ ((section (USER_CMD_SECTION), used))
+
+extern user_command_t wrboot_cmd_start[];
+extern user_command_t wrboot_cmd_end[];
+
 typedef struct user_subcommand {
     const char *name;
     void (*cmdfunc)(int argc, const char **);
     const char *helpstr;
 } user_subcommand_t;
 
+/*
+ * Status of the last command: 0, or non-zero when it failed.  execcmd()
+ * clears it, a command sets it on failure.  Command lines test it with
+ * "&&" and "||", e.g. "load flash kernel x && boot flash || reset".
+ */
+extern int cmd_status;
+
 /* General interfaces */
 extern void add_command(user_command_t *cmd);
-void execcmd(int, const char **);
-void exec_string(char *);
+user_command_t *find_cmd(const char *cmdname);
+int cmd_dispatch(const char *line);
+int execcmd(int, const char **);
+int exec_string(char *);
 void execsubcmd(user_subcommand_t *, int, const char **);
 void print_usage(char *strhead, user_subcommand_t *);
 void invalid_cmd(const char *cmd_name, user_subcommand_t *cmds);
-int init_builtin_cmds(void);
+
+/* Scripts */
+int run_script(const char *text, unsigned long size, int verbose);
+void run_boot_script(void);
 
 /* Porocessor memory map */
 #define ROM_BASE0    0x00000000      /* base address of rom bank 0 */
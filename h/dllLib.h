@@ -0,0 +1,140 @@
+/* dllLib.h - doubly linked list library header */
+
+#ifndef __INCdllLibh
+#define __INCdllLibh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* type definitions */
+
+typedef struct dlnode       /* Node of a linked list. */
+    {
+    struct dlnode *next;    /* Points at the next node in the list */
+    struct dlnode *previous;    /* Points at the previous node in the list */
+    } DL_NODE;
+
+/* HIDDEN */
+
+typedef struct          /* Header for a linked list. */
+    {
+    DL_NODE *head;  /* header of list */
+    DL_NODE *tail;  /* tail of list */
+    } DL_LIST;
+
+/* END_HIDDEN */
+
+/************************************************************************
+*
+* dllFirst - find first node in list
+*
+* DESCRIPTION
+* Finds the first node in a doubly linked list.
+*
+* RETURNS
+*   Pointer to the first node in a list, or
+*   NULL if the list is empty.
+*
+* NOMANUAL
+*/
+
+#define DLL_FIRST(pList)    \
+    (               \
+    (((DL_LIST *)pList)->head)  \
+    )
+
+/************************************************************************
+*
+* dllLast - find last node in list
+*
+* This routine finds the last node in a doubly linked list.
+*
+* RETURNS
+*  pointer to the last node in list, or
+*  NULL if the list is empty.
+*
+* NOMANUAL
+*/
+
+#define DLL_LAST(pList)     \
+    (               \
+    (((DL_LIST *)pList)->tail)  \
+    )
+
+/************************************************************************
+*
+* dllNext - find next node in list
+*
+* Locates the node immediately after the node pointed to by the pNode.
+*
+* RETURNS:
+*   Pointer to the next node in the list, or
+*   NULL if there is no next node.
+*
+* NOMANUAL
+*/
+
+#define DLL_NEXT(pNode)     \
+    (               \
+    (((DL_NODE *)pNode)->next)  \
+    )
+
+/************************************************************************
+*
+* dllPrevious - find previous node in list
+*
+* Locates the node immediately before the node pointed to by the pNode.
+*
+* RETURNS:
+*   Pointer to the previous node in the list, or
+*   NULL if there is no previous node.
+*
+* NOMANUAL
+*/
+
+#define DLL_PREVIOUS(pNode) \
+    (               \
+    (((DL_NODE *)pNode)->previous)  \
+    )
+
+/************************************************************************
+*
+* dllEmpty - boolean function to check for empty list
+*
+* RETURNS:
+*   TRUE if list is empty
+*   FALSE otherwise
+*
+* NOMANUAL
+*/
+
+#define DLL_EMPTY(pList)            \
+    (                       \
+    (((DL_LIST *)pList)->head == NULL)      \
+    )
+
+extern DL_NODE * dllEach
+    (
+    DL_LIST * pList,        /* linked list of nodes to call routine for */
+    int (* routine)     /* the routine to call for each list node */
+    (
+    DL_NODE * pNode,    /* pointer to a linked list node */
+    int arg /* arbitrary user-supplied argument */
+        ),
+    int routineArg  /* arbitrary user-supplied argument */
+    );
+extern DL_NODE *dllGet (DL_LIST *pList);
+extern int 	dllInit (DL_LIST *pList);
+extern int 	dllTerminate (DL_LIST *pList);
+extern int 	dllCount (DL_LIST *pList);
+extern void 	dllInsert (DL_LIST *pList, DL_NODE *pPrev, DL_NODE *pNode);
+extern void 	dllAdd (DL_LIST *pList, DL_NODE *pNode);
+extern void 	dllRemove (DL_LIST *pList, DL_NODE *pNode);
+
+#ifdef __cplusplus
+}
+
+#endif /* __cplusplus */
+
+#endif /* __INCdllLibh */
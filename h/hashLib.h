@@ -4,6 +4,17 @@
 #define __INChashLibh
 
 #include <sllLib.h>
+#include <dllLib.h>
+
+/*
+ * HASH_TBL_DLL selects the list type of the hash chains.  Doubly linked
+ * chains let hashTblRemove() unlink a node without walking its chain.
+ * Define it to 0 for singly linked chains, which take less memory per node.
+ */
+
+#ifndef HASH_TBL_DLL
+#define HASH_TBL_DLL            1
+#endif
 
 typedef int (*FUNCPTR) ();
 
@@ -15,7 +26,13 @@ extern "C" {
 #define M_hashLib               (58 << 16)
 #define S_hashLib_KEY_CLASH     (M_hashLib | 1)
 
+#if HASH_TBL_DLL
+typedef DL_NODE HASH_NODE;  /* HASH_NODE */
+typedef DL_LIST HASH_LIST;  /* HASH_LIST - hash chain head */
+#else
 typedef SL_NODE HASH_NODE;  /* HASH_NODE */
+typedef SL_LIST HASH_LIST;  /* HASH_LIST - hash chain head */
+#endif
 
 
 /* size of hash table given number of elements in hash table log 2 */
@@ -24,7 +41,26 @@ typedef int (* HASH_KEY_CMP_FUNC)(HASH_NODE *pNode, HASH_NODE *pHNode,int arg);
 typedef int (*HASH_FUNC) (int elements, HASH_NODE * pHNode, int arg);
 
 #define HASH_TBL_SIZE(sizeLog2)                     \
-    (((1 << (sizeLog2)) * sizeof (SL_LIST)) + sizeof (HASH_TBL))
+    (((1 << (sizeLog2)) * sizeof (HASH_LIST)) + sizeof (HASH_TBL))
+
+/* average chain length that doubles a table made by hashTblCreate() */
+
+#define HASH_TBL_GROW_LOAD      2
+
+/*
+ * Open addressing tables (hashTblOpenCreate) call the hashing function with
+ * HASH_OPEN_RANGE elements to get a wide hash, which is kept in the slot.
+ * They double when more than HASH_OPEN_LOAD_PCT percent of the slots are used.
+ */
+
+#define HASH_OPEN_RANGE         (1 << 30)
+#define HASH_OPEN_LOAD_PCT      75
+
+typedef struct          /* HASH_SLOT - open addressing table slot */
+    {
+    unsigned int  hash;     /* wide hash of the node */
+    HASH_NODE *   pNode;    /* hash node, or NULL if the slot is free */
+    } HASH_SLOT;
 
 /* type definitions */
 
@@ -32,9 +68,13 @@ typedef struct hashtbl      /* HASH_TBL */
     {
     HASH_KEY_CMP_FUNC keyCmpRtn;/* comparator function */
     HASH_FUNC     keyRtn;   /* hash function */
-    SL_LIST *     pHashTbl; /* pointer to hash table array */
+    HASH_LIST *   pHashTbl; /* pointer to hash table array */
     int keyArg; /* hash function argument */
     int       elements; /* number of elements in table */
+    int       nodes;    /* number of nodes in table */
+    int       growLoad; /* load that doubles the table, 0: fixed size */
+    HASH_LIST *   pHashMem; /* list heads allocated on growth, or NULL */
+    HASH_SLOT *   pSlots;   /* open addressing slots, or NULL if chained */
     } HASH_TBL;
 
 /* type definitions */
@@ -83,12 +123,19 @@ extern HASH_NODE *  hashTblFind (HASH_ID hashId, HASH_NODE * pMatchNode,
 extern int      hashLibInit (void);
 extern int      hashTblDelete (HASH_ID hashId);
 extern int      hashTblDestroy (HASH_ID hashId, int dealloc);
-extern int      hashTblInit (HASH_ID pHashTbl, SL_LIST * pTblMem,
+extern int      hashTblInit (HASH_ID pHashTbl, HASH_LIST * pTblMem,
                      int sizeLog2, FUNCPTR keyCmpRtn,
                      FUNCPTR keyRtn, int keyArg);
 extern int      hashTblPut (HASH_ID hashId, HASH_NODE * pHashNode);
 extern int      hashTblRemove (HASH_ID hashId, HASH_NODE * pHashNode);
 extern int      hashTblTerminate (HASH_ID hashId);
+extern int      hashTblGrowSet (HASH_ID hashId, int growLoad);
+extern HASH_ID      hashTblOpenCreate (int sizeLog2, FUNCPTR keyCmpRtn,
+                       FUNCPTR keyRtn, int keyArg);
+extern int      hashTblStats (HASH_ID hashId);
+extern unsigned int hashStrFnv1a (const char * str, unsigned int seed);
+extern int      hashFuncFnv1a (int elements, H_NODE_STRING * pHNode,
+                       int seed);
 extern int      hashFuncIterScale (int elements, H_NODE_STRING * pHNode,
                        int seed);
 extern int      hashFuncModulo (int elements, H_NODE_INT * pHNode,
@@ -5,6 +5,12 @@ extern void * kmalloc(unsigned long size);
 
 extern void kfree(void * block);
 
+extern void * xmalloc(unsigned long size);
+
+extern void * calloc(unsigned long num, unsigned long sz);
+
+extern void * kmalloc_max(unsigned long *size);
+
 extern unsigned long strtoul(const char *nptr, char **endptr, int base);
 
 extern unsigned long long int strtoull(const char *ptr, char **end, int base);
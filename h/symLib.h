@@ -15,6 +15,10 @@ extern "C" {
 
 #define SYM_EACH_CALL_WRITE 0x1 
 
+/* longest name returned for a symbol of the standalone table, with EOS */
+
+#define MAX_SYS_SYM_LEN 256
+
 /* Maximum number of concurrent symbol table reader */
 
 #define MAX_SYM_READERS 10
@@ -156,6 +160,8 @@ extern int  symFindSymbol       (SYMTAB_ID symTblId, char * name,
                      SYM_VALUE value, SYM_TYPE type,
                      SYM_TYPE mask, SYMBOL_ID * pSymbolId);
 extern int  symNameGet      (SYMBOL_ID symbolId, char ** pName);
+extern int  symNameCopy     (SYMBOL_ID symbolId, char * pBuf,
+                     unsigned long bufLen);
 extern SYMBOL_ID symRegister        (SYMTAB_ID symTblId, char * name,
                      SYM_VALUE value, SYM_TYPE type,
                      SYM_GROUP group, SYM_REF symRef, 
@@ -170,10 +176,15 @@ extern int  symValueGet     (SYMBOL_ID symbolId,
 extern int  symFree         (SYMTAB_ID symTblId, SYMBOL * pSymbol);
 extern int  symTblAdd       (SYMTAB_ID symTblId, SYMBOL * pSymbol);
 extern int  symTblRemove        (SYMTAB_ID symTblId, SYMBOL * pSymbol);
+extern SYMBOL * symEach         (SYMTAB_ID symTblId, FUNCPTR routine,
+                     int routineArg);
+extern SYMBOL * symEachPrefix       (SYMTAB_ID symTblId, char * prefix,
+                     FUNCPTR routine, int routineArg);
 extern SYMBOL_ID symEachCall        (SYMTAB_ID symTblId,
                      SYM_EACH_RTN_FUNCPTR routine,
                      int routineArg, int flags);
 extern int symFind (SYMTAB_ID symTblId,SYMBOL_DESC *pSymDesc); 
+extern SYMBOL_ID symByAddr      (SYM_VALUE addr, unsigned long * pOffset);
 
 #ifdef __cplusplus
 }
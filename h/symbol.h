@@ -4,6 +4,7 @@
 #define __INCsymbolh
 
 #include <sllLib.h>
+#include <dllLib.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,7 +19,7 @@ typedef unsigned long       SYM_REF;
 
 typedef struct symbol           /* SYMBOL - entry in symbol table */
     {
-    SL_NODE     nameHNode;      /* hash node (must come first) */
+    DL_NODE     nameHNode;      /* hash node (must come first) */
     char *  name;       /* pointer to symbol name */
     SYM_VALUE   value;      /* symbol value */
     SYM_REF symRef;     /* Id of module, or predefined SYMREF. */
@@ -147,6 +147,21 @@ extern int handleInit (HANDLE_ID handleId, enum handleType type);
 #define wr_write16(x,v) *(volatile unsigned short *)(x) = (v)
 #define wr_write32(x,v) *(volatile unsigned long *)(x) = (v)
 
+/*
+ * The boot loader is built -O0; hot loops (memory tests and benchmarks,
+ * CRCs, flash copies and compares) are marked FAST_FUNC to get -O2.
+ * They are kept out of line so the option is not lost by inlining.
+ */
+#define FAST_FUNC   __attribute__ ((noinline, optimize ("O2")))
+
+/* Time Base (boot/cpu/ppc) */
+extern unsigned int sysTimeBaseLGet (void);
+extern unsigned int sysTimeBaseFreqGet (void);
+
+/* console input */
+extern int tstc (void);
+extern int getc (void);
+
 __inline void  write(long *to, unsigned long value)
 {
     volatile long *addr = to;
@@ -95,6 +95,22 @@ void first_fit_free(void *block) {
     return;
 }
 
+/* largest free block, left free: its data is only valid until the next malloc */
+void *first_fit_max(unsigned long *size)
+{
+    blockhead *blockptr = gHeapBase;
+    blockhead *max = 0;
+
+    while (blockptr != 0) {
+        if (blockptr->allocated == 0 && (max == 0 || blockptr->size > max->size))
+            max = blockptr;
+        blockptr = blockptr->next;
+    }
+    *size = (max != 0) ? max->size & ~7 : 0;
+
+    return (max != 0) ? ((unsigned char *)(max)+sizeof(blockhead)) : 0;
+}
+
 
 
 void * kmalloc(unsigned long size)
@@ -107,6 +123,11 @@ void kfree(void * block)
 return first_fit_free(block);
 }
 
+void * kmalloc_max(unsigned long *size)
+{
+return first_fit_max(size);
+}
+
 
 /******************************************************************************
 *
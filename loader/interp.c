@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <symbol.h>
 #include <symLib.h>
+#include <command.h>
 
 /* Defines */
 
@@ -187,8 +188,10 @@ static int dumpCommandFunc
 *
 * This function calls the DEMO interpreter parser.
 *
-* It breaks the input line <inputLine> into understandable tokens and call
-* the corresponding DEMO command with its arguments.
+* An input line <inputLine> whose first word names a registered command
+* (see command.h) is run by that command.  Otherwise it is broken into
+* understandable tokens and the symbol named by the first one is called
+* with its arguments.
 *
 * RETURNS: OK or ERROR
 *
@@ -224,6 +227,11 @@ static int dumpCommandFunc
     if (strlen (statement) == 0)
     return OK;
 
+    /* Registered commands take precedence over symbol calls */
+
+    if (cmd_dispatch (statement) == 0)
+    return OK;
+
     /* Split statement into a command name and an argument string */
 
     if (statementSplit (statement, &command, &argument) != OK)
@@ -19,12 +19,16 @@
 # network.
 #
 # The built-in symbol table is an array of type SYMBOL accessible through
-# the global variable `standTbl'.  The array contains `standTblSize' elements.
-# These are the only external declarations in the generated code. When the
-# standalone VxWorks image is built from a BSP the symbols are inserted in
-# the system symbol table  by usrRoot() in usrConfig.c. When the standalone
-# VxWorks image is built from a project, the symbols are inserted by the
-# usrStandaloneInit() routine in the comps/src/usrStandalone.c configlette.
+# the global variable `standTbl'.  The array contains `standTblSize' elements
+# sorted by name.  It is followed by the const tables of a minimal perfect
+# hash of the names (`standTblHashSize', `standTblHashDisp' and
+# `standTblHashIdx', see phashCreate).  symLib looks names up directly in
+# these tables, so nothing is inserted into a hash table at startup.  The
+# uninitialized `standTblAddr' array is the value-sorted index of symLib.
+#
+# The names are not stored as separate strings: the name pointer of every
+# entry is NULL and the names are front coded in `standTblNames' (see
+# namesCreate).  symLib decodes them on demand.
 #
 # For an example, see the file $WIND_BASE/target/config/<bspName>/symTbl.c,
 # which is generated by this tool for `vxWorks.st' in the same directory.
@@ -51,6 +55,7 @@ namespace eval makeSymTbl {
     set symPrefixToAdd	""
     set cpuType		""
     set fdOut           ""
+    set phashMaxSeed	1000000
     set symDecl() ""
     set symDefT() ""
     set symDefD() ""
@@ -222,22 +227,282 @@ proc makeSymTbl::standTblCreate {modName} {
 
     set nsyms [llength $symbolTblEntryList]
 
+    # Sort the entries by name (strcmp order) so that the table itself is the
+    # name-sorted index; symbols with the same name end up next to each other.
+
+    set symbolTblSortList {}
+    foreach symbolTblEntry $symbolTblEntryList {
+	regexp {"([^"]*)"} $symbolTblEntry dummy name
+	lappend symbolTblSortList [list $name $symbolTblEntry]
+    }
+    set symbolTblSortList [lsort -ascii -index 0 $symbolTblSortList]
+
     # convert nm output to symbol entries in array
 
     puts $fdOut ""
     puts $fdOut "SYMBOL ${symPrefixToAdd}standTbl \[$nsyms\] ="
     puts $fdOut "    {"
 
-    foreach symbolTblEntry $symbolTblEntryList {
+    set keyList {}
+    set keyIndexList {}
+    set nameList {}
+    set prevName ""
+    set ix 0
+    foreach symbolTblSort $symbolTblSortList {
+	set name [lindex $symbolTblSort 0]
+	regsub {"[^"]*"} [lindex $symbolTblSort 1] "NULL" symbolTblEntry
         puts $fdOut "        $symbolTblEntry"
+	lappend nameList $name
+
+	# only the first of several symbols with the same name is hashed
+
+	if {$ix == 0 || $name ne $prevName} {
+	    lappend keyList $name
+	    lappend keyIndexList $ix
+	}
+	set prevName $name
+	incr ix
     }
 
     puts $fdOut "    };"
     puts $fdOut ""
 
+    # Room for the address index; the final addresses are only known after
+    # the last link, so symLib sorts it on the first search by value.
+
+    set addrSize [expr {$nsyms > 0 ? $nsyms : 1}]
+    puts $fdOut "SYMBOL * ${symPrefixToAdd}standTblAddr \[$addrSize\];"
+    puts $fdOut ""
+
+    namesCreate $nameList
+    phashCreate $keyList $keyIndexList
+
     return $nsyms
 }
 
+##############################################################################
+#
+# namesCreate - write the front coded symbol names
+#
+# This procedure writes the sorted names of <nameList> to symTbl.c as the
+# `standTblNames' array. Each name is stored as one byte giving the length
+# of the prefix it shares with the previous name (at most 255), followed by
+# the rest of the name and an EOS. Every `standTblNameStep'th name starts a
+# group and is stored whole; standTblNameBkt[] holds the offset of each
+# group in standTblNames[], so a name is decoded from at most
+# standTblNameStep entries.
+#
+# SYNOPSIS:
+#   namesCreate { nameList }
+#
+# PARAMETERS:
+#   nameList: symbol names, in standTbl[] order
+#
+# RETURNS: N/A
+#
+
+proc makeSymTbl::namesCreate {nameList} {
+    variable symPrefixToAdd
+    variable fdOut
+
+    set step 16
+    set offList {}
+    set off 0
+    set prevName ""
+    set ix 0
+
+    puts $fdOut "const char ${symPrefixToAdd}standTblNames \[\] ="
+    foreach name $nameList {
+	if {$ix % $step == 0} {
+	    lappend offList $off
+	    set prefix 0
+	} else {
+	    set max [string length $prevName]
+	    if {$max > 255} {
+		set max 255
+	    }
+	    for {set prefix 0} {$prefix < $max} {incr prefix} {
+		if {[string index $name $prefix] ne \
+		    [string index $prevName $prefix]} {
+		    break
+		}
+	    }
+	}
+	set suffix [string range $name $prefix end]
+	puts $fdOut "    \"[format {\%03o} $prefix]$suffix\\0\""
+	incr off [expr {[string length $suffix] + 2}]
+	set prevName $name
+	incr ix
+    }
+    if {$ix == 0} {
+	lappend offList 0
+	puts $fdOut "    \"\""
+    }
+    puts $fdOut "    ;"
+    puts $fdOut ""
+    puts $fdOut "const unsigned int ${symPrefixToAdd}standTblNameStep = ${step};"
+    puts $fdOut ""
+    puts $fdOut "const unsigned int ${symPrefixToAdd}standTblNameBkt \[[llength $offList]\] ="
+    puts $fdOut "    {"
+    foreach off $offList {
+	puts $fdOut "        $off,"
+    }
+    puts $fdOut "    };"
+    puts $fdOut ""
+}
+
+##############################################################################
+#
+# phashHash - hash a symbol name
+#
+# This is the 32 bit FNV-1a hash with the offset basis xor'ed by <seed>; it
+# must give the same result as hashStrFnv1a() in hashLib.c.
+#
+# SYNOPSIS:
+#   phashHash { name seed }
+#
+# RETURNS: the hash value
+#
+
+proc makeSymTbl::phashHash {name seed} {
+    set hash [expr {2166136261 ^ $seed}]
+
+    binary scan $name cu* chars
+    foreach c $chars {
+	set hash [expr {(($hash ^ $c) * 16777619) & 0xffffffff}]
+    }
+
+    return $hash
+}
+
+##############################################################################
+#
+# phashCreate - create a minimal perfect hash of the symbol names
+#
+# This procedure writes the tables of a "hash and displace" minimal perfect
+# hash of the <keyList> names to symTbl.c. A name is first hashed with seed 0
+# to pick an entry of standTblHashDisp[]. A positive entry is the seed of a
+# second hash which gives the slot, a negative entry -1 - slot gives the slot
+# directly. standTblHashIdx[slot] is the standTbl[] index of the name.
+#
+# Buckets are placed largest first: for each bucket the seeds 1, 2, ... are
+# tried until all its names land in distinct free slots. Buckets of one name
+# are put in the remaining free slots without a second hash.
+#
+# standTblHashIdx[] is unsigned int, so any standTbl[] index fits.
+#
+# SYNOPSIS:
+#   phashCreate { keyList keyIndexList }
+#
+# PARAMETERS:
+#   keyList: distinct symbol names
+#   keyIndexList: standTbl[] index of each name
+#
+# RETURNS: N/A
+#
+# ERRORS: no seed up to phashMaxSeed places a bucket
+#
+
+proc makeSymTbl::phashCreate {keyList keyIndexList} {
+    variable symPrefixToAdd
+    variable fdOut
+    variable phashMaxSeed
+
+    set nkeys [llength $keyList]
+    set size [expr {$nkeys > 0 ? $nkeys : 1}]
+
+    # sort the names into buckets by their first hash
+
+    for {set i 0} {$i < $size} {incr i} {
+	set bucket($i) {}
+	set disp($i) 0
+	set slot($i) -1
+    }
+    set k 0
+    foreach key $keyList {
+	lappend bucket([expr {[phashHash $key 0] % $size}]) $k
+	incr k
+    }
+
+    set bucketList {}
+    for {set i 0} {$i < $size} {incr i} {
+	lappend bucketList [list $i [llength $bucket($i)]]
+    }
+    set bucketList [lsort -integer -decreasing -index 1 $bucketList]
+
+    # find a seed for each bucket of several names
+
+    set freeList {}
+    foreach b $bucketList {
+	set i [lindex $b 0]
+	if {[lindex $b 1] <= 1} {
+	    break
+	}
+
+	for {set seed 1} {$seed <= $phashMaxSeed} {incr seed} {
+	    set slotList {}
+	    foreach k $bucket($i) {
+		set s [expr {[phashHash [lindex $keyList $k] $seed] % $size}]
+		if {$slot($s) != -1 || [lsearch -exact $slotList $s] != -1} {
+		    break
+		}
+		lappend slotList $s
+	    }
+	    if {[llength $slotList] == [llength $bucket($i)]} {
+		break
+	    }
+	}
+	if {$seed > $phashMaxSeed} {
+	    error "makeSymTbl: no perfect hash seed up to $phashMaxSeed\
+		   for a bucket of [llength $bucket($i)] names"
+	}
+
+	set disp($i) $seed
+	foreach k $bucket($i) s $slotList {
+	    set slot($s) $k
+	}
+    }
+
+    # put the single name buckets in the free slots
+
+    for {set s 0} {$s < $size} {incr s} {
+	if {$slot($s) == -1} {
+	    lappend freeList $s
+	}
+    }
+    foreach b $bucketList {
+	set i [lindex $b 0]
+	if {[lindex $b 1] != 1} {
+	    continue
+	}
+	set s [lindex $freeList 0]
+	set freeList [lrange $freeList 1 end]
+	set disp($i) [expr {-1 - $s}]
+	set slot($s) [lindex $bucket($i) 0]
+    }
+
+    puts $fdOut "const unsigned int ${symPrefixToAdd}standTblHashSize = ${nkeys};"
+    puts $fdOut ""
+    puts $fdOut "const int ${symPrefixToAdd}standTblHashDisp \[$size\] ="
+    puts $fdOut "    {"
+    for {set i 0} {$i < $size} {incr i} {
+	puts $fdOut "        $disp($i),"
+    }
+    puts $fdOut "    };"
+    puts $fdOut ""
+    puts $fdOut "const unsigned int ${symPrefixToAdd}standTblHashIdx \[$size\] ="
+    puts $fdOut "    {"
+    for {set s 0} {$s < $size} {incr s} {
+	if {$slot($s) == -1} {
+	    puts $fdOut "        0,"
+	} else {
+	    puts $fdOut "        [lindex $keyIndexList $slot($s)],"
+	}
+    }
+    puts $fdOut "    };"
+    puts $fdOut ""
+}
+
 ##############################################################################
 #
 # main - entry point of utility
@@ -282,9 +547,9 @@ puts $makeSymTbl::fdOut "#include \<symbol.h\>"
 puts $makeSymTbl::fdOut ""
 
 # The following are for symbols that require special handling. These include :
-# 1. Some symbols that are declared in sllLib.h, which is included through
-#    symbol.h. They must be declared correctly or they cause multiple 
-#    definition complaints.
+# 1. Some symbols that are declared in sllLib.h and dllLib.h, which are
+#    included through symbol.h. They must be declared correctly or they
+#    cause multiple definition complaints.
 # Since a symbol can have only one type at a time, symDecl is sufficient for
 # both DATA and TEXT types. However, as a symbol can have different, manually
 # specified, definitions for TEXT and DATA, we need symDefT and symDefD.
@@ -299,6 +564,11 @@ set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}sllEach) "IMPORT SL_NODE *\
 set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}sllPutAtHead) "IMPORT void \$cName ();"
 set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}sllPutAtTail) "IMPORT void \$cName ();"
 set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}sllRemove) "IMPORT void \$cName ();"
+set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}dllGet) "IMPORT DL_NODE *\$cName \(\);"
+set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}dllEach) "IMPORT DL_NODE *\$cName \(\);"
+set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}dllInsert) "IMPORT void \$cName ();"
+set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}dllAdd) "IMPORT void \$cName ();"
+set makeSymTbl::symDecl(${makeSymTbl::symPrefixToAdd}dllRemove) "IMPORT void \$cName ();"
 
 # DATA symbols that require special DEFINITION handling
 # (add yours here if needed with the symDefD assertion)
@@ -0,0 +1,276 @@
+/* dllLib.c - doubly linked list subroutine library */
+
+/*
+DESCRIPTION
+This subroutine library supports the creation and maintenance of a
+doubly linked list.  The user supplies a list head (type DL_LIST)
+that will contain pointers to the first and last nodes in the list.
+The nodes in the list can be any user-defined structure, but they must reserve
+space for two pointers as their first elements.  Both the forward and
+backward chains are terminated with a NULL pointer.
+
+Unlike sllLib, a node knows its predecessor, so dllRemove() takes constant
+time wherever the node is in the list.  The first pointer of a DL_NODE is the
+forward link, as in an SL_NODE.
+
+.ne 16
+NON-EMPTY LIST:
+.CS
+
+   ---------             --------          --------
+   | head--------------->| next----------->| next---------
+   |       |             |      |          |      |      |
+   |       |       ------| prev |<---------| prev |      |
+   |       |       |     |      |          |      |      |
+   | tail------    |     | ...  |    ----->| ...  |      |
+   |-------|  |    v                 |                   v
+              |  -----               |                 -----
+              |   ---                |                  ---
+              |    -                 |                   -
+              ------------------------
+
+.CE
+.ne 12
+EMPTY LIST:
+.CS
+
+    -----------
+        |  head------------------
+        |         |             |
+        |  tail----------       |
+        |         |     v       v
+        |         |   -----   -----
+        -----------    ---     ---
+                        -   -
+
+.CE
+
+INCLUDE FILE: dllLib.h
+*/
+
+
+/* LINTLIBRARY */
+
+#include <wrboot.h>
+#include <stdlib.h>
+#include <dllLib.h>
+
+/*******************************************************************************
+*
+* dllInit - initialize doubly linked list head
+*
+* Initialize the specified list to an empty list.
+*
+* RETURNS: OK, or ERROR if intialization failed.
+*/
+
+int dllInit
+    (
+    DL_LIST *pList     /* pointer to list head to be initialized */
+    )
+    {
+    pList->head  = NULL;            /* initialize list */
+    pList->tail  = NULL;
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* dllTerminate - terminate doubly linked list head
+*
+* Terminate the specified list.
+*
+* RETURNS: OK, or ERROR if doubly linked list could not be terminated.
+*
+* ARGSUSED
+*/
+
+int dllTerminate
+    (
+    DL_LIST *pList     /* pointer to list head to be initialized */
+    )
+    {
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* dllInsert - insert node in list after specified node
+*
+* This routine inserts the specified node in the specified list.
+* The new node is placed following the list node <pPrev>.
+* If <pPrev> is NULL, the node is inserted at the head of the list.
+*
+* SEE ALSO: dllAdd()
+*/
+
+void dllInsert
+    (
+    DL_LIST *pList,     /* pointer to list descriptor */
+    DL_NODE *pPrev,     /* pointer to node after which to insert */
+    DL_NODE *pNode      /* pointer to node to be inserted */
+    )
+    {
+    DL_NODE *pNext;
+
+    if (pPrev == NULL)
+    {               /* new node is to be first in list */
+    pNext = pList->head;
+    pList->head = pNode;
+    }
+    else
+    {               /* make prev node point fwd to new */
+    pNext = pPrev->next;
+    pPrev->next = pNode;
+    }
+
+    if (pNext == NULL)
+    pList->tail = pNode;    /* new node is to be last in list */
+    else
+    pNext->previous = pNode;    /* make next node point back to new */
+
+    /* set pointers in new node */
+
+    pNode->next     = pNext;
+    pNode->previous = pPrev;
+    }
+
+/*******************************************************************************
+*
+* dllAdd - add node to end of list
+*
+* This routine adds the specified node to the end of the specified list.
+*
+* SEE ALSO: dllInsert()
+*/
+
+void dllAdd
+    (
+    DL_LIST *pList,     /* pointer to list descriptor */
+    DL_NODE *pNode      /* pointer to node to be added */
+    )
+    {
+    dllInsert (pList, pList->tail, pNode);
+    }
+
+/*******************************************************************************
+*
+* dllRemove - remove specified node in list
+*
+* Remove the specified node in the doubly linked list.  The list does not
+* have to be walked, whatever the position of the node.
+*/
+
+void dllRemove
+    (
+    DL_LIST *pList,             /* pointer to list head */
+    DL_NODE *pNode              /* pointer to node to be deleted */
+    )
+    {
+    if (pNode->previous == NULL)
+    pList->head = pNode->next;
+    else
+    pNode->previous->next = pNode->next;
+
+    if (pNode->next == NULL)
+    pList->tail = pNode->previous;
+    else
+    pNode->next->previous = pNode->previous;
+    }
+
+/*******************************************************************************
+*
+* dllGet - get (delete and return) first node from list
+*
+* This routine gets the first node from the specified doubly linked list,
+* deletes the node from the list, and returns a pointer to the node gotten.
+*
+* RETURNS: Pointer to the node gotten, or NULL if the list is empty.
+*/
+
+DL_NODE *dllGet
+    (
+    FAST DL_LIST *pList         /* pointer to list from which to get node */
+    )
+    {
+    FAST DL_NODE *pNode = pList->head;
+
+    if (pNode != NULL)
+        dllRemove (pList, pNode);
+
+    return (pNode);
+    }
+
+/*******************************************************************************
+*
+* dllCount - report number of nodes in list
+*
+* This routine returns the number of nodes in the given list.
+*
+* CAVEAT
+* This routine must actually traverse the list to count the nodes.
+*
+* RETURNS: Number of nodes in specified list.
+*/
+
+int dllCount
+    (
+    DL_LIST *pList      /* pointer to list head */
+    )
+    {
+    FAST DL_NODE *pNode = DLL_FIRST (pList);
+    FAST int count = 0;
+
+    while (pNode != NULL)
+    {
+    count ++;
+    pNode = DLL_NEXT (pNode);
+    }
+
+    return (count);
+    }
+
+/*******************************************************************************
+*
+* dllEach - call a routine for each node in a linked list
+*
+* This routine calls a user-supplied routine once for each node in the
+* linked list.  The routine should be declared as follows:
+* .CS
+*  int routine (pNode, arg)
+*      DL_NODE *pNode;  /@ pointer to a linked list node    @/
+*      int arg; /@ arbitrary user-supplied argument @/
+* .CE
+* The user-supplied routine should return TRUE if dllEach() is to
+* continue calling it with the remaining nodes, or FALSE if it is done and
+* dllEach() can exit.  The routine may remove the node it is given.
+*
+* RETURNS: NULL if traversed whole linked list, or pointer to DL_NODE that
+*          dllEach ended with.
+*/
+
+DL_NODE * dllEach
+    (
+    DL_LIST * pList,        /* linked list of nodes to call routine for */
+    int (* routine)     /* the routine to call for each list node */
+    (
+    DL_NODE * pNode,    /* pointer to a linked list node */
+    int arg /* arbitrary user-supplied argument */
+        ),
+    int routineArg  /* arbitrary user-supplied argument */
+    )
+    {
+    FAST DL_NODE *pNode = DLL_FIRST (pList);
+    FAST DL_NODE *pNext;
+
+    while (pNode != NULL)
+    {
+    pNext = DLL_NEXT (pNode);
+    if ((* routine) (pNode, routineArg) == FALSE)
+        break;
+    pNode = pNext;
+    }
+
+    return (pNode);         /* return node we ended with */
+    }
@@ -5,8 +5,8 @@ DESCRIPTION
 This subroutine library supports the creation and maintenance of a
 chained hash table.  Hash tables efficiently store hash nodes for fast access.
 They are frequently used for symbol tables, or other name to identifier
-functions.  A chained hash table is an array of singly linked list heads,
-with one list head per element of the hash table.  During creation, a hash table
+functions.  A chained hash table is an array of linked list heads, with one
+list head per element of the hash table.  During creation, a hash table
 is passed two user-definable functions, the hashing function, and the hash node
 comparator.
 
@@ -127,6 +127,33 @@ STRUCTURE
 
 \ce
 
+OPEN ADDRESSING
+hashTblOpenCreate() makes a table without lists.  It is a flat array of
+HASH_SLOTs, each holding a node pointer and the wide hash of the node, kept
+in order by Robin Hood linear probing: a new node goes in front of the first
+node that is closer to its home slot than the new one would be.  A lookup only calls the comparator
+when the cached hash matches, and stops as soon as it reaches a node closer
+to its home than the probe is, so misses end early.  Removal shifts the
+following nodes back instead of leaving deleted markers.  hashTblPut(),
+hashTblFind(), hashTblRemove(), hashTblEach() and hashTblDelete() take
+either kind of table.  hashTblEach() walks an open table in slot order.
+
+TABLE GROWTH
+A table made by hashTblCreate() doubles its number of elements when the
+average chain length passes HASH_TBL_GROW_LOAD; all nodes are then hashed
+again into a new array of list heads.  hashTblGrowSet() changes the limit,
+or fixes the size of the table.  Tables set up with hashTblInit() keep their
+size unless hashTblGrowSet() is used.  hashTblStats() prints a histogram of
+the chain lengths.
+
+CHAIN LISTS
+With HASH_TBL_DLL set to 1 (the default, see hashLib.h) the chains are doubly
+linked dllLib lists, so hashTblRemove() unlinks a node without looking for
+its predecessor; removal costs one call of the hashing function whatever the
+length of the chain.  With HASH_TBL_DLL set to 0 the chains are sllLib lists,
+a HASH_NODE is one pointer smaller, and hashTblRemove() walks the chain from
+its head.
+
 CAVEATS
 Hash tables must have a number of elements equal to a power of two.
 
@@ -137,7 +164,34 @@ INCLUDE FILE: hashLib.h
 #include <hashLib.h>
 #include <string.h>
 #include <sllLib.h>
+#include <dllLib.h>
 #include <stdlib.h>
+#include <stdio.h>
+
+#define HASH_FNV_BASIS          2166136261U /* FNV-1a offset basis */
+#define HASH_FNV_PRIME          16777619U  /* FNV-1a prime */
+#define HASH_STATS_CHAINS       8          /* histogram: 0..7 and 8+ nodes */
+
+/* chain list operations */
+
+#if HASH_TBL_DLL
+#define HASH_LIST_INIT(pList)           dllInit (pList)
+#define HASH_LIST_FIRST(pList)          ((HASH_NODE *) DLL_FIRST (pList))
+#define HASH_LIST_NEXT(pNode)           ((HASH_NODE *) DLL_NEXT (pNode))
+#define HASH_LIST_PUT_HEAD(pList, pNode) dllInsert (pList, NULL, pNode)
+#define HASH_LIST_PUT_TAIL(pList, pNode) dllAdd (pList, pNode)
+#define HASH_LIST_REMOVE(pList, pNode)  dllRemove (pList, pNode)
+#define HASH_LIST_EACH(pList, rtn, arg) dllEach (pList, rtn, arg)
+#else
+#define HASH_LIST_INIT(pList)           sllInit (pList)
+#define HASH_LIST_FIRST(pList)          ((HASH_NODE *) SLL_FIRST (pList))
+#define HASH_LIST_NEXT(pNode)           ((HASH_NODE *) SLL_NEXT (pNode))
+#define HASH_LIST_PUT_HEAD(pList, pNode) sllPutAtHead (pList, pNode)
+#define HASH_LIST_PUT_TAIL(pList, pNode) sllPutAtTail (pList, pNode)
+#define HASH_LIST_REMOVE(pList, pNode)                                  \
+    sllRemove (pList, pNode, sllPrevious (pList, pNode))
+#define HASH_LIST_EACH(pList, rtn, arg) sllEach (pList, rtn, arg)
+#endif
 
 extern int ffsMsb (unsigned int i);
 
@@ -181,7 +235,7 @@ HASH_ID hashTblCreate
     )
     {
     HASH_ID    hashId;
-    SL_LIST *  pList;
+    HASH_LIST * pList;
 
     /* check sizeLog2 */
 
@@ -191,10 +245,13 @@ HASH_ID hashTblCreate
     hashId  = (HASH_ID) kmalloc (HASH_TBL_SIZE (sizeLog2));
     printf ("DEBUG: hashTblCreate creating hash table @0x%x. \n",hashId);    
 
-    pList = (SL_LIST *) (((unsigned char *) hashId) + sizeof(HASH_TBL));
+    pList = (HASH_LIST *) (((unsigned char *) hashId) + sizeof(HASH_TBL));
 
     if (hashId != NULL)
-    (void)hashTblInit (hashId, pList, sizeLog2, keyCmpRtn, keyRtn, keyArg);
+        {
+        (void)hashTblInit (hashId, pList, sizeLog2, keyCmpRtn, keyRtn, keyArg);
+        hashId->growLoad = HASH_TBL_GROW_LOAD;
+        }
 
     return (hashId);                /* return the hash id */
     }
@@ -219,7 +276,7 @@ HASH_ID hashTblCreate
 int hashTblInit
     (
     HASH_ID       hashId,       /* id of hash table to initialize */
-    SL_LIST       *pTblMem,     /* pointer to memory of sizeLog2 SL_LISTs */
+    HASH_LIST     *pTblMem,     /* pointer to memory of sizeLog2 HASH_LISTs */
     int           sizeLog2,     /* number of elements in hash table log 2 */
     FUNCPTR       keyCmpRtn,    /* function to test keys for equivalence */
     FUNCPTR       keyRtn,       /* hashing function to generate hash from key */
@@ -230,7 +287,7 @@ int hashTblInit
 
     /* 
      * Validate the size, the hash table Id, and 
-     * the SL list before continuing. 
+     * the list heads before continuing. 
      * Must also check the Rtn's passed otherwise
      * the APIs, e.g. hashTblPut(), later will crash.
      */
@@ -247,11 +304,15 @@ int hashTblInit
     hashId->keyRtn  = (HASH_FUNC) keyRtn;   /* store hashing function */
     hashId->keyArg  = keyArg;       /* store hashing function arg */
     hashId->pHashTbl    = pTblMem;
+    hashId->nodes       = 0;
+    hashId->growLoad    = 0;                /* fixed size */
+    hashId->pHashMem    = NULL;
+    hashId->pSlots      = NULL;             /* chained */
 
     /* initialize all of the linked list heads in the table */
 
     for (ix = 0; ix < hashId->elements; ix++)
-         sllInit (&hashId->pHashTbl [ix]);
+         HASH_LIST_INIT (&hashId->pHashTbl [ix]);
 
     return (OK);
     }
@@ -298,7 +359,8 @@ int hashTblTerminate
 * hashTblDestroy - destroy a hash table
 *
 * This routine destroys the specified hash table and optionally kfrees the
-* associated memory.  The hash table is marked as invalid.
+* associated memory.  The list heads allocated when the table grew are always
+* kfreed.  The hash table is marked as invalid.
 *
 * RETURNS: OK, or ERROR if <hashId> is invalid.
 *
@@ -310,18 +372,327 @@ int hashTblDestroy
     int    dealloc             /* deallocate associated memory */
     )
     {
+    if (hashId == NULL)
+        return (ERROR);
+
+    if (hashId->pHashMem != NULL)
+        kfree ((char *) hashId->pHashMem);
+
+    if (hashId->pSlots != NULL)
+        kfree ((char *) hashId->pSlots);
+
     if (dealloc)
     kfree ((char *) hashId);
 
     return (OK);
     }
 
+/*******************************************************************************
+*
+* hashTblGrow - double the number of elements of a hash table
+*
+* This routine allocates twice as many list heads and hashes every node of
+* the table again.  Nodes are appended in their current order, so identical
+* nodes keep their order.  If the memory is not available the table is left
+* as it is.
+*
+* RETURNS: OK, or ERROR if the new list heads could not be allocated.
+*
+* \NOMANUAL
+*/
+
+LOCAL int hashTblGrow
+    (
+    HASH_ID     hashId          /* id of hash table to grow */
+    )
+    {
+    HASH_LIST * pOldTbl = hashId->pHashTbl;
+    HASH_LIST * pNewTbl;
+    int         oldElements = hashId->elements;
+    HASH_NODE * pNode;
+    HASH_NODE * pNext;
+    int         ix;
+    int         index;
+
+    pNewTbl = (HASH_LIST *) kmalloc (2 * oldElements * sizeof (HASH_LIST));
+
+    if (pNewTbl == NULL)
+        return (ERROR);
+
+    hashId->elements = 2 * oldElements;
+    hashId->pHashTbl = pNewTbl;
+
+    for (ix = 0; ix < hashId->elements; ix++)
+        HASH_LIST_INIT (&pNewTbl [ix]);
+
+    for (ix = 0; ix < oldElements; ix++)
+        {
+        for (pNode = HASH_LIST_FIRST (&pOldTbl [ix]); pNode != NULL;
+             pNode = pNext)
+            {
+            pNext = HASH_LIST_NEXT (pNode);
+            index = (* hashId->keyRtn) (hashId->elements, pNode,
+                                        hashId->keyArg);
+            HASH_LIST_PUT_TAIL (&pNewTbl [index], pNode);
+            }
+        }
+
+    if (hashId->pHashMem != NULL)
+        kfree ((char *) hashId->pHashMem);
+
+    hashId->pHashMem = pNewTbl;
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* hashTblGrowSet - set the load factor that grows a hash table
+*
+* This routine sets the average number of nodes per element above which
+* hashTblPut() doubles the table.  A <growLoad> of 0 fixes the size of the
+* table.  Tables made by hashTblCreate() start with HASH_TBL_GROW_LOAD.
+*
+* RETURNS: OK, or ERROR if <hashId> is invalid or <growLoad> is negative.
+*
+*/
+
+int hashTblGrowSet
+    (
+    HASH_ID     hashId,         /* id of hash table */
+    int         growLoad        /* nodes per element, 0 for a fixed size */
+    )
+    {
+    if ((hashId == NULL) || (growLoad < 0))
+        return (ERROR);
+
+    hashId->growLoad = growLoad;
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* hashTblOpenCreate - create an open addressing hash table
+*
+* This routine creates a hash table of 2^sizeLog2 HASH_SLOTs, see OPEN
+* ADDRESSING above.  The parameters are those of hashTblCreate().  The table
+* doubles when it is HASH_OPEN_LOAD_PCT percent full, whatever its growth
+* load, so hashTblGrowSet() has no effect on it.
+*
+* RETURNS: HASH_ID, or NULL if hash table could not be created.
+*
+*/
+
+HASH_ID hashTblOpenCreate
+    (
+    int            sizeLog2,  /* number of slots in hash table log 2 */
+    FUNCPTR        keyCmpRtn, /* function to test keys for equivalence */
+    FUNCPTR        keyRtn,    /* hashing function to generate hash from key */
+    int            keyArg     /* argument to hashing function */
+    )
+    {
+    HASH_ID    hashId;
+
+    if ((sizeLog2 < 1) || (sizeLog2 >= 30) ||
+        (keyCmpRtn == NULL) || (keyRtn == NULL))
+        return (NULL);
+
+    hashId = (HASH_ID) kmalloc (sizeof (HASH_TBL));
+
+    if (hashId == NULL)
+        return (NULL);
+
+    memset (hashId, 0, sizeof (HASH_TBL));
+
+    hashId->pSlots = (HASH_SLOT *) kmalloc ((1 << sizeLog2) * sizeof (HASH_SLOT));
+
+    if (hashId->pSlots == NULL)
+        {
+        kfree ((char *) hashId);
+        return (NULL);
+        }
+
+    memset (hashId->pSlots, 0, (1 << sizeLog2) * sizeof (HASH_SLOT));
+
+    hashId->elements  = 1 << sizeLog2;
+    hashId->keyCmpRtn = (HASH_KEY_CMP_FUNC) keyCmpRtn;
+    hashId->keyRtn    = (HASH_FUNC) keyRtn;
+    hashId->keyArg    = keyArg;
+
+    return (hashId);
+    }
+
+/*******************************************************************************
+*
+* hashOpenInsert - put a node in the slots of an open addressing table
+*
+* This routine does the Robin Hood insertion.  The node moves along from its
+* home slot up to the first node that is closer to its own home, takes that
+* slot, and the nodes from there to the next free slot move up by one.  If
+* <ahead> is TRUE, the node also stops at a node that is as far from home, so
+* that of several identical nodes the last one put is found first, as in a
+* chained table.  Moving the nodes up keeps the order of identical nodes.
+* The caller makes sure a slot is free.
+*
+* RETURNS: N/A
+*
+* \NOMANUAL
+*/
+
+LOCAL void hashOpenInsert
+    (
+    HASH_ID         hashId,     /* open addressing hash table */
+    unsigned int    hash,       /* wide hash of the node */
+    HASH_NODE *     pNode,      /* node to put */
+    int             ahead       /* go before nodes as far from home */
+    )
+    {
+    HASH_SLOT *     pSlots = hashId->pSlots;
+    unsigned int    mask = (unsigned int) hashId->elements - 1;
+    unsigned int    ix = hash & mask;
+    unsigned int    dist = 0;   /* distance of the node from its home */
+    unsigned int    slotDist;   /* distance of the slot's node from home */
+    HASH_SLOT       carry;      /* node being put or moved up */
+    HASH_SLOT       tmp;
+
+    while (pSlots [ix].pNode != NULL)
+        {
+        slotDist = (ix - pSlots [ix].hash) & mask;
+
+        if ((slotDist < dist) || (ahead && (slotDist == dist)))
+            break;
+
+        ix = (ix + 1) & mask;
+        dist++;
+        }
+
+    carry.hash  = hash;
+    carry.pNode = pNode;
+
+    while (pSlots [ix].pNode != NULL)
+        {
+        tmp          = pSlots [ix];
+        pSlots [ix]  = carry;
+        carry        = tmp;
+        ix = (ix + 1) & mask;
+        }
+
+    pSlots [ix] = carry;
+    }
+
+/*******************************************************************************
+*
+* hashOpenGrow - double the number of slots of an open addressing table
+*
+* Nodes are put again in slot order, each behind the identical ones before
+* it, so their order does not change.
+*
+* RETURNS: OK, or ERROR if the new slots could not be allocated.
+*
+* \NOMANUAL
+*/
+
+LOCAL int hashOpenGrow
+    (
+    HASH_ID     hashId          /* open addressing hash table */
+    )
+    {
+    HASH_SLOT * pOldSlots = hashId->pSlots;
+    int         oldElements = hashId->elements;
+    int         oldMask = oldElements - 1;
+    HASH_SLOT * pNewSlots;
+    HASH_SLOT * pSlot;
+    int         start;
+    int         ix;
+
+    pNewSlots = (HASH_SLOT *) kmalloc (2 * oldElements * sizeof (HASH_SLOT));
+
+    if (pNewSlots == NULL)
+        return (ERROR);
+
+    memset (pNewSlots, 0, 2 * oldElements * sizeof (HASH_SLOT));
+
+    hashId->pSlots   = pNewSlots;
+    hashId->elements = 2 * oldElements;
+
+    /*
+     * Start at a free slot or at a node in its home slot, so that a run of
+     * nodes wrapping around the end of the array is put in probe order.
+     */
+
+    for (start = 0; start < oldElements; start++)
+        {
+        pSlot = &pOldSlots [start];
+
+        if ((pSlot->pNode == NULL) || (((start - pSlot->hash) & oldMask) == 0))
+            break;
+        }
+
+    for (ix = 0; ix < oldElements; ix++)
+        {
+        pSlot = &pOldSlots [(start + ix) & oldMask];
+
+        if (pSlot->pNode != NULL)
+            hashOpenInsert (hashId, pSlot->hash, pSlot->pNode, FALSE);
+        }
+
+    kfree ((char *) pOldSlots);
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* hashOpenFind - find the slot of a node in an open addressing table
+*
+* This routine probes from the home slot of <hash> and returns the first
+* slot whose node has the same hash and either is <pNode>, if <exact> is
+* TRUE, or matches <pNode> for the key comparator.  The probe stops at a free
+* slot or at a node closer to its home than the probe is.
+*
+* RETURNS: index of the slot, or -1 if no node matches.
+*
+* \NOMANUAL
+*/
+
+LOCAL int hashOpenFind
+    (
+    HASH_ID         hashId,     /* open addressing hash table */
+    unsigned int    hash,       /* wide hash of <pNode> */
+    HASH_NODE *     pNode,      /* node to match */
+    int             keyCmpArg,  /* parameter to be passed to key comparator */
+    int             exact       /* match the <pNode> pointer itself */
+    )
+    {
+    HASH_SLOT *     pSlots = hashId->pSlots;
+    unsigned int    mask = (unsigned int) hashId->elements - 1;
+    unsigned int    ix = hash & mask;
+    unsigned int    dist;
+
+    for (dist = 0; pSlots [ix].pNode != NULL; dist++)
+        {
+        if (((ix - pSlots [ix].hash) & mask) < dist)
+            break;
+
+        if ((pSlots [ix].hash == hash) &&
+            (exact ? (pSlots [ix].pNode == pNode) :
+             (* hashId->keyCmpRtn) (pNode, pSlots [ix].pNode, keyCmpArg)))
+            return ((int) ix);
+
+        ix = (ix + 1) & mask;
+        }
+
+    return (-1);
+    }
+
 /*******************************************************************************
 *
 * hashTblPut - put a hash node into the specified hash table
 *
 * This routine puts the specified hash node in the specified hash table.
-* Identical nodes will be kept in FIFO order in the hash table.
+* Identical nodes will be kept in FIFO order in the hash table.  The table is
+* doubled when the node count passes its load factor (see hashTblGrowSet()).
 *
 * RETURNS: OK, or ERROR if <hashId> is invalid.
 *
@@ -335,13 +706,38 @@ int hashTblPut
     {
     int     index;
 
+    if (hashId->pSlots != NULL)
+        {
+        /* keep a free slot and the load below HASH_OPEN_LOAD_PCT */
+
+        if (((hashId->nodes + 1) * 100 > hashId->elements * HASH_OPEN_LOAD_PCT)
+            && (hashOpenGrow (hashId) != OK) &&
+            (hashId->nodes + 1 >= hashId->elements))
+            return (ERROR);
+
+        hashOpenInsert (hashId,
+                        (unsigned int) (* hashId->keyRtn) (HASH_OPEN_RANGE,
+                                                           pHashNode,
+                                                           hashId->keyArg),
+                        pHashNode, TRUE);
+        hashId->nodes++;
+
+        return (OK);
+        }
+
     /* invoke hash table's hashing routine to get index into table */
 
     index = (* hashId->keyRtn) (hashId->elements, pHashNode, hashId->keyArg);
 
     /* add hash node to head of linked list */
 
-    sllPutAtHead (&hashId->pHashTbl [index], pHashNode);
+    HASH_LIST_PUT_HEAD (&hashId->pHashTbl [index], pHashNode);
+
+    hashId->nodes++;
+
+    if ((hashId->growLoad > 0) &&
+        (hashId->nodes > hashId->elements * hashId->growLoad))
+        (void) hashTblGrow (hashId);    /* keeps the old table on failure */
 
     return (OK);
     }
@@ -366,17 +762,28 @@ HASH_NODE * hashTblFind
     FAST HASH_NODE * pHNode;
     int              ix;
 
+    if (hashId->pSlots != NULL)
+        {
+        ix = hashOpenFind (hashId,
+                           (unsigned int) (* hashId->keyRtn) (HASH_OPEN_RANGE,
+                                                              pMatchNode,
+                                                              hashId->keyArg),
+                           pMatchNode, keyCmpArg, FALSE);
+
+        return ((ix < 0) ? NULL : hashId->pSlots [ix].pNode);
+        }
+
     /* invoke hash table's hashing routine to get index into table */
 
     ix = (* hashId->keyRtn) (hashId->elements, pMatchNode, hashId->keyArg);
 
     /* search linked list for above hash index and return matching hash node */
 
-    pHNode = (HASH_NODE *) SLL_FIRST (&hashId->pHashTbl [ix]);
+    pHNode = HASH_LIST_FIRST (&hashId->pHashTbl [ix]);
 
     while ((pHNode != NULL) &&
        !((* hashId->keyCmpRtn) (pMatchNode, pHNode, keyCmpArg)))
-         pHNode = (HASH_NODE *) SLL_NEXT (pHNode);
+         pHNode = HASH_LIST_NEXT (pHNode);
 
     return (pHNode);
     }
@@ -397,16 +804,48 @@ int hashTblRemove
     HASH_NODE * pHashNode      /* pointer to hash node to remove */
     )
     {
-    HASH_NODE * pPrevNode;
     int         ix;
+    unsigned int mask;
+    unsigned int next;
+
+    if (hashId->pSlots != NULL)
+        {
+        HASH_SLOT * pSlots = hashId->pSlots;
+
+        ix = hashOpenFind (hashId,
+                           (unsigned int) (* hashId->keyRtn) (HASH_OPEN_RANGE,
+                                                              pHashNode,
+                                                              hashId->keyArg),
+                           pHashNode, 0, TRUE);
+        if (ix < 0)
+            return (ERROR);
+
+        /* shift the following displaced nodes back by one slot */
+
+        mask = (unsigned int) hashId->elements - 1;
+
+        for (next = (ix + 1) & mask;
+             (pSlots [next].pNode != NULL) &&
+             (((next - pSlots [next].hash) & mask) != 0);
+             next = (next + 1) & mask)
+            {
+            pSlots [ix] = pSlots [next];
+            ix = (int) next;
+            }
+
+        pSlots [ix].pNode = NULL;
+        hashId->nodes--;
+
+        return (OK);
+        }
 
     /* invoke hash table's hashing routine to get index into table */
 
     ix = (* hashId->keyRtn) (hashId->elements, pHashNode, hashId->keyArg);
 
-    pPrevNode = sllPrevious (&hashId->pHashTbl [ix], pHashNode);
+    HASH_LIST_REMOVE (&hashId->pHashTbl [ix], pHashNode);
 
-    sllRemove (&hashId->pHashTbl [ix], pHashNode, pPrevNode);
+    hashId->nodes--;
 
     return (OK);
     }
@@ -443,12 +882,167 @@ HASH_NODE * hashTblEach
     FAST int        ix;
     HASH_NODE *     pNode = NULL;
 
+    if (hashId->pSlots != NULL)
+        {
+        for (ix = 0; ix < hashId->elements; ix++)
+            {
+            pNode = hashId->pSlots [ix].pNode;
+
+            if ((pNode != NULL) && !(* routine) (pNode, routineArg))
+                return (pNode);
+            }
+
+        return (NULL);
+        }
+
     for (ix = 0; (ix < hashId->elements) && (pNode == NULL); ix++)
-    pNode = (HASH_NODE *)sllEach (&hashId->pHashTbl[ix], routine, routineArg);
+    pNode = (HASH_NODE *)HASH_LIST_EACH (&hashId->pHashTbl[ix], routine, routineArg);
 
     return (pNode);     /* return node we ended with */
     }
 
+/*******************************************************************************
+*
+* hashTblStats - show the chain lengths of a hash table
+*
+* This routine prints the size and load of the specified hash table and a
+* histogram of the number of elements whose chain holds 0, 1, ... nodes.  The
+* longest chain bounds the number of key comparisons of hashTblFind().  For
+* an open addressing table the histogram counts the nodes that are 0, 1, ...
+* slots away from their home slot.
+*
+* RETURNS: OK, or ERROR if <hashId> is invalid.
+*
+*/
+
+int hashTblStats
+    (
+    HASH_ID     hashId          /* hash table to show */
+    )
+    {
+    int         hist [HASH_STATS_CHAINS + 1];
+    HASH_NODE * pNode;
+    int         maxLen = 0;
+    int         len;
+    int         ix;
+
+    if (hashId == NULL)
+        return (ERROR);
+
+    memset (hist, 0, sizeof (hist));
+
+    for (ix = 0; ix < hashId->elements; ix++)
+        {
+        if (hashId->pSlots != NULL)
+            {
+            if (hashId->pSlots [ix].pNode == NULL)
+                continue;
+
+            /* probe length: distance of the node from its home slot */
+
+            len = (ix - hashId->pSlots [ix].hash) & (hashId->elements - 1);
+            }
+        else
+            {
+            len = 0;
+
+            for (pNode = HASH_LIST_FIRST (&hashId->pHashTbl [ix]);
+                 pNode != NULL; pNode = HASH_LIST_NEXT (pNode))
+                len++;
+            }
+
+        if (len > maxLen)
+            maxLen = len;
+
+        hist [(len < HASH_STATS_CHAINS) ? len : HASH_STATS_CHAINS]++;
+        }
+
+    printf ("%s: %d\n", "Elements", hashId->elements);
+    printf ("%s: %d\n", "Nodes", hashId->nodes);
+    printf ("%s: %d.%02d\n", "Load Factor", hashId->nodes / hashId->elements,
+            (hashId->nodes % hashId->elements) * 100 / hashId->elements);
+
+    if (hashId->pSlots != NULL)
+        {
+        printf ("%s: %d\n", "Longest Probe", maxLen);
+        printf ("Probe  Nodes\n");
+        }
+    else
+        {
+        printf ("%s: %d\n", "Longest Chain", maxLen);
+
+        if (hashId->growLoad > 0)
+            printf ("%s: %d\n", "Grow Load", hashId->growLoad);
+        else
+            printf ("%s: %s\n", "Grow Load", "fixed size");
+
+        printf ("Chain  Elements\n");
+        }
+
+    for (ix = 0; ix <= HASH_STATS_CHAINS; ix++)
+        {
+        if (hist [ix] == 0)
+            continue;
+
+        printf ((ix < HASH_STATS_CHAINS) ? "%5d  %d\n" : "%4d+  %d\n",
+                ix, hist [ix]);
+        }
+
+    return (OK);
+    }
+
+/*******************************************************************************
+*
+* hashStrFnv1a - FNV-1a hash of a string
+*
+* This routine returns the 32 bit FNV-1a hash of the null terminated string
+* <str>, with the offset basis xor'ed by <seed>.  Unlike a sum of the
+* characters, it tells apart anagrams and names sharing a long prefix.  All
+* 32 bits are usable, so hash tables can simply mask the low bits.
+*
+* RETURNS: the 32 bit hash value
+*
+* ERRNO: N/A
+*/
+
+unsigned int hashStrFnv1a
+    (
+    const char *    str,        /* null terminated string */
+    unsigned int    seed        /* seed, 0 for plain FNV-1a */
+    )
+    {
+    FAST unsigned int hash = HASH_FNV_BASIS ^ seed;
+
+    while (*str != '\0')
+        hash = (hash ^ (unsigned char) *str++) * HASH_FNV_PRIME;
+
+    return (hash);
+    }
+
+/*******************************************************************************
+*
+* hashFuncFnv1a - FNV-1a hashing function for strings
+*
+* This hashing function interprets the key as a pointer to a null terminated
+* string and masks its hashStrFnv1a() hash.  The <seed> is passed to
+* hashStrFnv1a().
+*
+* RETURNS: integer between 0 and (elements - 1)
+*
+* ERRNO: N/A
+*/
+
+int hashFuncFnv1a
+    (
+    int                 elements,      /* number of elements in hash table */
+    H_NODE_STRING *     pHNode,        /* pointer to string keyed hash node */
+    int                 seed           /* seed for hashStrFnv1a() */
+    )
+    {
+    return (int) (hashStrFnv1a (pHNode->string, (unsigned int) seed) &
+                  (unsigned int) (elements - 1));
+    }
+
 /*******************************************************************************
 *
 * hashFuncIterScale - iterative scaling hashing function for strings
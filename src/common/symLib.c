@@ -7,15 +7,36 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#define SYM_TBL_HASH_SIZE_LOG2  8          /* 256 entry hash table symbol table */
 #define SYM_HFUNC_SEED          1370364821 /* magic seed */
 
 extern SYMBOL       standTbl[];            /* standalone symbol table array */
 extern unsigned int standTblSize;          /* symbols in standalone table */
-extern int ffsMsb (unsigned int i);
+extern const unsigned int   standTblHashSize;   /* names in perfect hash */
+extern const int            standTblHashDisp[]; /* perfect hash seeds */
+extern const unsigned int   standTblHashIdx[];  /* slot to standTbl index */
+extern SYMBOL *     standTblAddr[];        /* standTbl sorted by value */
+extern const char   standTblNames[];       /* front coded standTbl names */
+extern const unsigned int   standTblNameStep;   /* names per coding group */
+extern const unsigned int   standTblNameBkt[];  /* offset of each group */
 
 SYMTAB_ID       sysSymTbl;                 /* system symbol table id */
 
+LOCAL SYMTAB    standSymTbl;               /* ROM resident system table */
+
+typedef struct          /* SYM_VALUE_SRCH - search by value in a hash table */
+    {
+    SYM_VALUE   value;          /* value of symbol to search for */
+    SYM_TYPE    type;           /* symbol type */
+    SYM_TYPE    mask;           /* type bits that matter */
+    SYMBOL *    pBestSymbol;    /* symbol with lower value, matching type */
+    } SYM_VALUE_SRCH;
+LOCAL int       standTblAddrOk = FALSE;    /* standTblAddr[] is sorted */
+
+LOCAL char      symRomName [MAX_SYS_SYM_LEN];   /* last decoded ROM name */
+LOCAL int       symRomNameIx = -1;         /* its standTbl index, or -1 */
+LOCAL unsigned int  symRomNameLen;         /* its length */
+LOCAL const unsigned char * symRomNameNext;     /* coded name that follows */
+
 /*******************************************************************************
 *
 * symKeyCmpName - compare two symbols' names 
@@ -56,9 +77,8 @@ LOCAL int symKeyCmpName
 *
 * symHFuncName - symbol name hash function
 *
-* This routine applies a checksum algorithm to the name and uses 
-* that as the input to a multiplicative hashing function provided 
-* by hashFuncMultiply().
+* This routine hashes the name with hashStrFnv1a(), seeded by <seed>, and
+* masks the result to the size of the table.
 *
 * RETURNS: An integer between 0 and (elements - 1).
 * 
@@ -69,23 +89,240 @@ LOCAL int symHFuncName
     (
     int         elements,       /* no. of elements in hash table */
     SYMBOL      *pSymbol,       /* pointer to symbol */
-    int         seed            /* seed to be used as scalar */
+    int         seed            /* seed for hashStrFnv1a() */
+    )
+    {
+    return (int) (hashStrFnv1a (pSymbol->name, (unsigned int) seed) &
+                  (unsigned int) (elements - 1));
+    }
+
+/*******************************************************************************
+*
+* symRomNameDecode - decode a name of the standalone symbol table
+*
+* The names of standTbl[] are front coded in standTblNames[] by
+* loader/makeSymTbl.tcl: each one is a byte giving the length of the prefix
+* shared with the previous name, then the rest of the name and an EOS.  Every
+* standTblNameStep'th name is stored whole and starts a group.  This routine
+* rebuilds the name of standTbl[<ix>] from the start of its group, or from
+* the last decoded name when <ix> follows it in the same group, so a walk in
+* table order decodes each name once.  Names are truncated to
+* MAX_SYS_SYM_LEN - 1 characters.
+*
+* RETURNS: pointer to the name, valid until the next call.
+*
+* \NOMANUAL
+*/
+
+LOCAL char * symRomNameDecode
+    (
+    unsigned int    ix          /* standTbl index */
+    )
+    {
+    const unsigned char *   p;  /* next coded name */
+    unsigned int    jx;         /* standTbl index of the name at <p> */
+    unsigned int    len;        /* length of the name decoded so far */
+
+    if ((symRomNameIx >= 0) && (ix >= (unsigned int) symRomNameIx) &&
+        (ix / standTblNameStep ==
+         (unsigned int) symRomNameIx / standTblNameStep))
+        {
+        if (ix == (unsigned int) symRomNameIx)
+            return symRomName;
+
+        p   = symRomNameNext;
+        jx  = (unsigned int) symRomNameIx + 1;
+        len = symRomNameLen;
+        }
+    else
+        {
+        p   = (const unsigned char *) standTblNames +
+              standTblNameBkt [ix / standTblNameStep];
+        jx  = ix - ix % standTblNameStep;
+        len = 0;
+        }
+
+    for (; jx <= ix; jx++)
+        {
+        if (*p < len)
+            len = *p;           /* keep the shared prefix */
+        p++;
+
+        for (; *p != EOS; p++)
+            {
+            if (len < MAX_SYS_SYM_LEN - 1)
+                symRomName [len++] = (char) *p;
+            }
+        p++;
+        }
+
+    symRomName [len] = EOS;
+    symRomNameIx     = (int) ix;
+    symRomNameLen    = len;
+    symRomNameNext   = p;
+
+    return symRomName;
+    }
+
+/*******************************************************************************
+*
+* symRomNameCmp - compare a name of the standalone symbol table
+*
+* This routine checks whether standTbl[<ix>] is named <name> without
+* decoding the names of its group: it only tracks how many characters of
+* <name> each coded name of the group shares.  A name whose shared prefix is
+* longer than that count differs from <name> at the same place as the
+* previous one.
+*
+* RETURNS: TRUE if the names are the same, FALSE otherwise.
+*
+* \NOMANUAL
+*/
+
+LOCAL int symRomNameCmp
+    (
+    unsigned int    ix,         /* standTbl index */
+    const char *    name        /* name to compare with */
     )
     {
-    int         hash;
-    char    *tkey;
-    int         key = 0;
+    const unsigned char *   p;  /* next coded name */
+    unsigned int    jx;         /* standTbl index of the name at <p> */
+    unsigned int    match = 0;  /* characters of <name> matched */
+    int             same;       /* the name at <p> is <name> */
+
+    p  = (const unsigned char *) standTblNames +
+         standTblNameBkt [ix / standTblNameStep];
 
-    /* checksum the string and use a multiplicative hashing function */
+    for (jx = ix - ix % standTblNameStep; ; jx++)
+        {
+        same = FALSE;
+
+        if (*p <= match)
+            {
+            match = *p++;
 
-    for (tkey = pSymbol->name; *tkey != '\0'; tkey++)
-    key = key + (unsigned int) *tkey;
+            while ((*p != EOS) && (*p == (unsigned char) name [match]))
+                {
+                p++;
+                match++;
+                }
 
-    hash = key * seed;              /* multiplicative hash func */
+            same = (*p == EOS) && (name [match] == EOS);
+            }
+        else
+            p++;
 
-    hash = hash >> (33 - ffsMsb (elements));    /* take only the leading bits */
+        if (jx == ix)
+            return same;
 
-    return (hash & (elements - 1));     /* mask hash to (0,elements-1)*/
+        while (*p++ != EOS)
+            ;
+        }
+    }
+
+/*******************************************************************************
+*
+* symRomFind - find a symbol by name in the standalone symbol table
+*
+* This routine looks <name> up in the minimal perfect hash generated in
+* symTbl.c.  The first hash selects a displacement: a negative one is the
+* slot itself, otherwise it is the seed of a second hash giving the slot.
+* The slot holds the standTbl[] index of the name, which has to be checked
+* since a name that is not in the table gets an arbitrary slot; this is done
+* on the coded name by symRomNameCmp().  standTbl[] is sorted by name, so
+* symbols sharing a name follow the hashed one.  Both hashes are
+* hashStrFnv1a(), as in phashHash of loader/makeSymTbl.tcl.
+*
+* RETURNS: pointer to the symbol, or NULL if no symbol matches.
+*
+* \NOMANUAL
+*/
+
+LOCAL SYMBOL * symRomFind
+    (
+    char *      name,           /* name to search for */
+    SYM_TYPE    type,           /* symbol type */
+    SYM_TYPE    mask            /* type bits that matter */
+    )
+    {
+    int             disp;       /* displacement of the first hash */
+    unsigned int    slot;       /* perfect hash slot */
+    unsigned int    ix;         /* standTbl index */
+
+    if (standTblHashSize == 0)
+        return NULL;
+
+    disp = standTblHashDisp [hashStrFnv1a (name, 0) % standTblHashSize];
+
+    if (disp < 0)
+        slot = (unsigned int) (-1 - disp);
+    else
+        slot = hashStrFnv1a (name, (unsigned int) disp) % standTblHashSize;
+
+    for (ix = standTblHashIdx [slot];
+         (ix < standTblSize) && symRomNameCmp (ix, name);
+         ix++)
+        {
+        if ((standTbl[ix].type & mask) == (type & mask))
+            return &standTbl[ix];
+        }
+
+    return NULL;
+    }
+
+/*******************************************************************************
+*
+* symRomLowerBound - find where a name sorts in the standalone symbol table
+*
+* This routine returns the index of the first standTbl[] symbol whose name
+* does not sort below <name> (strcmp() order).  The names starting with a
+* given prefix follow each other from the lower bound of the prefix, which
+* makes prefix queries a binary search.  The first name of each group of
+* standTblNames[] is stored whole, so the groups are binary searched without
+* decoding, then the names of one group are decoded in order.
+*
+* RETURNS: a standTbl[] index, standTblSize if all names sort below <name>.
+*
+* \NOMANUAL
+*/
+
+unsigned int symRomLowerBound
+    (
+    const char *    name        /* name to look for */
+    )
+    {
+    unsigned int    lo = 0;     /* first group not known to start below */
+    unsigned int    hi;
+    unsigned int    mid;
+    unsigned int    ix;
+
+    hi = (standTblSize + standTblNameStep - 1) / standTblNameStep;
+
+    /* lo = number of groups whose first name sorts below <name> */
+
+    while (lo < hi)
+        {
+        mid = lo + (hi - lo) / 2;
+
+        if (strcmp (standTblNames + standTblNameBkt [mid] + 1, name) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+        }
+
+    if (lo == 0)
+        return 0;
+
+    /* the bound is in group lo - 1, after its first name, or starts group lo */
+
+    for (ix = (lo - 1) * standTblNameStep + 1;
+         (ix < lo * standTblNameStep) && (ix < standTblSize); ix++)
+        {
+        if (strcmp (symRomNameDecode (ix), name) >= 0)
+            return ix;
+        }
+
+    return ix;
     }
 
 /*******************************************************************************
@@ -95,6 +332,8 @@ LOCAL int symHFuncName
 * This routine creates and initializes a symbol table with a hash table of a
 * specified size.  The size of the hash table is specified as a power of two.
 * For example, if <hashSizeLog2> is 6, a 64-entry hash table is created.
+* The hash table is an open addressing one (see hashTblOpenCreate()), which
+* doubles as symbols are added.
 *
 * If the <sameNameOk> parameter is FALSE, attempting to add a symbol with
 * the same name and type as an already-existing symbol in the symbol table
@@ -117,12 +356,12 @@ SYMTAB_ID symTblCreate
 
     if (symTblId != NULL)
     {
-    symTblId->nameHashId = hashTblCreate (hashSizeLog2,
+    symTblId->nameHashId = hashTblOpenCreate (hashSizeLog2,
                           symKeyCmpName,
                           symHFuncName,
                           SYM_HFUNC_SEED);
 
-    if (symTblId->nameHashId == NULL)   /* hashTblCreate failed? */
+    if (symTblId->nameHashId == NULL)   /* hashTblOpenCreate failed? */
         {
         kfree ((void *) symTblId);
         printf ("\nDEBUG: symTblCreate failed to create hash "
@@ -151,15 +390,16 @@ int symTblAdd
     SYMBOL *    pSymbol     /* pointer to symbol to add */
     )
     {
-    if (symTblId == NULL)
-        return ERROR;
+    if ((symTblId == NULL) || (symTblId->nameHashId == NULL))
+        return ERROR;           /* the standalone table is read-only */
 
     if ((!symTblId->sameNameOk) &&
-    (hashTblFind (symTblId->nameHashId, &pSymbol->nameHNode,
+    (hashTblFind (symTblId->nameHashId, (HASH_NODE *) &pSymbol->nameHNode,
               (int) SYM_MASK_ALL) != NULL))
         return ERROR;
 
-    if (hashTblPut (symTblId->nameHashId, &pSymbol->nameHNode) != OK)
+    if (hashTblPut (symTblId->nameHashId,
+                    (HASH_NODE *) &pSymbol->nameHNode) != OK)
         return ERROR; /* hashTblPut() sets the errno, if any */
 
     symTblId->nsymbols++;          /* increment symbol count */
@@ -167,7 +407,36 @@ int symTblAdd
     return OK;
     }
 
-#define SYM_ADD_ERROR_COUNT 10
+/*******************************************************************************
+*
+* symTblRemove - remove a symbol from a symbol table
+*
+* This routine removes the symbol <pSymbol> from a symbol table, without
+* freeing it.  The symbol node is unlinked directly, so the cost does not
+* depend on the number of symbols with the same hash.
+*
+* RETURNS: OK, or ERROR if the table is the read-only standalone table or
+* the symbol is not in it.
+*/
+
+int symTblRemove
+    (
+    SYMTAB_ID   symTblId,   /* symbol table to remove symbol from */
+    SYMBOL *    pSymbol     /* pointer to symbol to remove */
+    )
+    {
+    if ((symTblId == NULL) || (symTblId->nameHashId == NULL) ||
+        (pSymbol == NULL))
+        return ERROR;           /* the standalone table is read-only */
+
+    if (hashTblRemove (symTblId->nameHashId,
+                       (HASH_NODE *) &pSymbol->nameHNode) != OK)
+        return ERROR;
+
+    symTblId->nsymbols--;          /* decrement symbol count */
+
+    return OK;
+    }
 
 /*******************************************************************************
 *
@@ -180,6 +449,10 @@ int symTblAdd
 * routine symFindSymbol().  A pointer to the symbol table's copy of the
 * symbol name is returned in <pName>.
 *
+* The names of the standalone table are front coded; for its symbols the
+* name is decoded into a buffer that the next lookup in that table may
+* overwrite.  Use symNameCopy() to keep it.
+*
 * RETURNS: OK, or ERROR if either <pName> or <symbolId> is NULL.
 *
 */
@@ -193,78 +466,303 @@ int symNameGet
     if ((symbolId == NULL) || (pName == NULL))
     return ERROR;
 
-    *pName = symbolId->name;
+    if (symbolId->name == NULL)         /* standalone table symbol */
+        *pName = symRomNameDecode (symbolId - standTbl);
+    else
+        *pName = symbolId->name;
+
+    return OK;
+    }
+
+/*******************************************************************************
+*
+* symNameCopy - copy the name of a symbol to a buffer
+*
+* This routine copies the name of the symbol <symbolId> to <pBuf>, decoding
+* it if the symbol is in the standalone table.  At most <bufLen> - 1
+* characters are copied and the name is always terminated by EOS.
+*
+* RETURNS: OK, or ERROR if <symbolId> or <pBuf> is NULL or <bufLen> is 0.
+*/
+
+int symNameCopy
+    (
+    SYMBOL_ID       symbolId,   /* symbol to get the name of */
+    char *          pBuf,       /* where to copy the name */
+    unsigned long   bufLen      /* size of <pBuf> */
+    )
+    {
+    char *      name;
+
+    if ((pBuf == NULL) || (bufLen == 0) ||
+        (symNameGet (symbolId, &name) != OK))
+        return ERROR;
+
+    strncpy (pBuf, name, bufLen);
+    pBuf [bufLen - 1] = EOS;
 
     return OK;
     }
 
 /******************************************************************************
 *
-* usrStandaloneInit - initialize the built-in symbol table
+* sym_table_init - initialize the system symbol table
+*
+* This routine makes the standalone symbol table generated in symTbl.c the
+* system symbol table <sysSymTbl>.  Name lookups go through the perfect hash
+* built by makeSymTbl.tcl, so nothing is inserted or allocated at startup.
+*
+* RETURNS: N/A
+*
 */ 
 
-void usrStandaloneInit (void)
+void sym_table_init(void)
+{
+    standSymTbl.nameHashId = NULL;           /* no hash: ROM lookups */
+    standSymTbl.sameNameOk = TRUE;
+    standSymTbl.nsymbols   = standTblSize;
+
+    sysSymTbl = &standSymTbl;
+}
+
+
+/*******************************************************************************
+*
+* symNameBiased - check for a name biased against in searches by value
+*
+* The loader and the GNU toolkit add symbols like "<file>_text" or "xxx.o"
+* which share their value with real routines or variables.  A search by value
+* returns such a symbol only if no other one has the same value; see
+* symFindSymbol().
+*
+* RETURNS: TRUE if <name> is one of these symbols, FALSE otherwise.
+*
+* \NOMANUAL
+*/
+
+LOCAL int symNameBiased
+    (
+    char *      name            /* symbol name */
+    )
+    {
+    char *      pUnder;         /* string for _text, etc., check */
+
+    if (((pUnder = strrchr (name, '_')) != NULL) &&
+        ((strcmp (pUnder, "_text") == 0) ||
+         (strcmp (pUnder, "_data") == 0) ||
+         (strcmp (pUnder, "_bss") == 0) ||
+         (strcmp (pUnder, "_compiled.") == 0)))
+        return TRUE;
+
+    if (((pUnder = strrchr (name, '.')) != NULL) &&
+        (strcmp (pUnder, ".o") == 0))
+        return TRUE;
+
+    return FALSE;
+    }
+
+/*******************************************************************************
+*
+* symValueCheck - check a symbol in a search by value
+*
+* This routine is called by hashTblEach() for each symbol in a search by
+* value of symFindSymbol().  If <pSymbol> is of the right type and below the
+* searched value but above the best symbol so far, it becomes the best symbol.
+*
+* RETURNS: FALSE if <pSymbol> is an exact match, to end the search, or TRUE.
+*
+* \NOMANUAL
+*/
+
+LOCAL int symValueCheck
+    (
+    SYMBOL *            pSymbol,    /* symbol to check */
+    SYM_VALUE_SRCH *    pSrch       /* search by value in progress */
+    )
+    {
+    SYM_VALUE   bestValue;      /* value of the best symbol so far */
+
+    bestValue = (pSrch->pBestSymbol == NULL) ? NULL :
+                pSrch->pBestSymbol->value;
+
+    if (((pSymbol->type & pSrch->mask) == (pSrch->type & pSrch->mask)) &&
+        (pSymbol->value == pSrch->value) &&
+        (!symNameBiased (pSymbol->name)) &&
+        (!(pSymbol->type & SYM_ABS)))
+        {
+        return FALSE;           /* we've found the entry */
+        }
+
+    if (((pSymbol->type & pSrch->mask) == (pSrch->type & pSrch->mask)) &&
+        ((pSymbol->value <= pSrch->value) &&
+         (pSymbol->value > bestValue)) &&
+        (!(pSymbol->type & SYM_ABS)))
+        {
+        /* This symbol is of correct type and closer than the last one */
+
+        pSrch->pBestSymbol = pSymbol;
+        }
+
+    return TRUE;
+    }
+
+/*******************************************************************************
+*
+* symAddrSort - sort the address index of the standalone symbol table
+*
+* This routine fills standTblAddr[] with pointers to the standTbl[] symbols
+* and heap sorts them by value, in place and without recursion.  It runs on
+* the first search by value instead of at startup.
+*
+* RETURNS: N/A
+*
+* \NOMANUAL
+*/
+
+LOCAL void symAddrSort (void)
     {
-    unsigned long   ix;
-    unsigned int    errCnt = 0;
-    char *          symName;
-    static char     symNameErr [] = "symNameGet() error!";
+    SYMBOL **       pTbl = standTblAddr;
+    SYMBOL *        pSymbol;    /* symbol being sifted down */
+    unsigned int    n = standTblSize;
+    unsigned int    ix;         /* next subtree to heapify */
+    unsigned int    parent;
+    unsigned int    child;
 
-    if (sysSymTbl == NULL)
-        return;
+    for (ix = 0; ix < n; ix++)
+        pTbl[ix] = &standTbl[ix];
 
-    printf ("\nAdding Standalone symbol table[0x%x-%d] into sysSymTbl (0x%x)\n",standTbl,standTblSize,sysSymTbl);
+    /* build the heap, then move its top to the end one at a time */
 
-    /* Fill system symbol table from the builtin one */
+    ix = n / 2;
 
-    for (ix = 0; ix < standTblSize; ix++)
+    while (n > 1)
         {
-        if (symTblAdd (sysSymTbl, &standTbl[ix]) != OK)
+        if (ix > 0)
+            {
+            parent  = --ix;
+            pSymbol = pTbl[parent];
+            }
+        else
             {
-            if (symNameGet (&standTbl[ix], &symName) != OK)
-                symName = symNameErr;
+            parent  = 0;
+            pSymbol = pTbl[--n];
+            pTbl[n] = pTbl[0];
+            }
+
+        child = 2 * parent + 1;
 
-            if (errCnt < SYM_ADD_ERROR_COUNT)
-                printf ("Error adding '%s' to the standalone symbol table "
-                  "(idx = %ld)!\n", symName, ix);
+        while (child < n)
+            {
+            if ((child + 1 < n) &&
+                (pTbl[child + 1]->value > pTbl[child]->value))
+                child++;
 
-            else if (errCnt == SYM_ADD_ERROR_COUNT)
-                printf ("...\n");
+            if (pTbl[child]->value <= pSymbol->value)
+                break;
 
-            errCnt++;
+            pTbl[parent] = pTbl[child];
+            parent = child;
+            child  = 2 * parent + 1;
             }
+
+        pTbl[parent] = pSymbol;
         }
 
-    if (errCnt != 0)
-    printf ("%ld symbols could not be registered.\n", errCnt);
+    standTblAddrOk = TRUE;
     }
 
-/******************************************************************************
+/*******************************************************************************
 *
-* sym_table_init - initialize the system symbol table
+* symAddrFind - find a symbol by value in the standalone symbol table
 *
-* This routine initializes the system symbol table <sysSymTbl>.
+* This routine binary searches standTblAddr[] for the symbols at or below
+* <value>, then walks down to the nearest one of the requested type.  Among
+* symbols sharing that value, one whose name is not biased against (see
+* symNameBiased()) is preferred.  Absolute symbols are never returned.
 *
-* RETURNS: N/A
+* RETURNS: pointer to the symbol, or NULL if there is no such symbol.
 *
-*/ 
+* \NOMANUAL
+*/
 
-void sym_table_init(void)
-{
-    /* create system and status symbol tables */
+LOCAL SYMBOL * symAddrFind
+    (
+    SYM_VALUE   value,          /* value of symbol to search for */
+    SYM_TYPE    type,           /* symbol type */
+    SYM_TYPE    mask            /* type bits that matter */
+    )
+    {
+    SYMBOL *        pBestSymbol = NULL; /* nearest symbol of the right type */
+    SYMBOL *        pSymbol;
+    unsigned int    lo = 0;
+    unsigned int    hi = standTblSize;
+    unsigned int    mid;
+
+    if (!standTblAddrOk)
+        symAddrSort ();
+
+    /* hi = number of symbols with a value lower than or equal to <value> */
+
+    while (lo < hi)
+        {
+        mid = lo + (hi - lo) / 2;
 
-    sysSymTbl = symTblCreate (SYM_TBL_HASH_SIZE_LOG2, TRUE);
+        if (standTblAddr[mid]->value <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+        }
 
-    printf ("DEBUG: symTblCreate creating symbol table @0x%x. \n",sysSymTbl);  
+    while (hi-- > 0)
+        {
+        pSymbol = standTblAddr[hi];
 
-    if (sysSymTbl == NULL)
-        printf ("sym_table_init: error creating the system symbol table.\n");
+        if ((pBestSymbol != NULL) && (pSymbol->value != pBestSymbol->value))
+            break;
 
-    usrStandaloneInit();
+        if (((pSymbol->type & mask) != (type & mask)) ||
+            (pSymbol->type & SYM_ABS))
+            continue;
 
-    symShow(sysSymTbl, "boot");
-}
+        if (!symNameBiased (symRomNameDecode (pSymbol - standTbl)))
+            return pSymbol;
 
+        if (pBestSymbol == NULL)
+            pBestSymbol = pSymbol;
+        }
+
+    return pBestSymbol;
+    }
+
+/*******************************************************************************
+*
+* symByAddr - find the symbol containing an address
+*
+* This routine returns the symbol of the system symbol table with the highest
+* value lower than or equal to <addr>, as needed by exception reports and
+* backtraces.  The distance from the symbol to <addr> is stored in
+* *<pOffset> if <pOffset> is not NULL.
+*
+* RETURNS: the symbol, or NULL if no symbol is below <addr>.
+*/
+
+SYMBOL_ID symByAddr
+    (
+    SYM_VALUE       addr,       /* address to look up */
+    unsigned long * pOffset     /* where to return the offset, or NULL */
+    )
+    {
+    SYMBOL_ID   symbolId;
+
+    if (symFindSymbol (sysSymTbl, NULL, addr, SYM_MASK_ANY_TYPE,
+                       SYM_MASK_ANY_TYPE, &symbolId) != OK)
+        return NULL;
+
+    if (pOffset != NULL)
+        *pOffset = (unsigned long) (addr - symbolId->value);
+
+    return symbolId;
+    }
 
 /*******************************************************************************
 *
@@ -332,14 +830,10 @@ int symFindSymbol
     {
     HASH_NODE *         pNode;      /* node in symbol hash table */
     SYMBOL              keySymbol;  /* dummy symbol for search by name */
-    int                 index;      /* counter for search by value */
-    SYMBOL *            pSymbol;    /* current symbol, search by value */
+    SYM_VALUE_SRCH      valueSrch;  /* search by value in the hash table */
+    SYMBOL *            pSymbol;    /* exact match, search by value */
     SYMBOL *            pBestSymbol = NULL; 
                                    /* symbol with lower value, matching type */
-    char *      pUnder;    /* string for _text, etc., check */
-    SYM_VALUE       bestValue = NULL; 
-                                    /* current value of symbol with matching 
-                       type */ 
 
     if (symTblId == NULL)
     return ERROR;
@@ -352,14 +846,20 @@ int symFindSymbol
     if (name != NULL) 
         {
     /* Search by name or by name and type: */
-      
-    /* fill in keySymbol */
 
-    keySymbol.name = name;          /* match this name */
-    keySymbol.type = type;          /* match this type */
+    if (symTblId->nameHashId == NULL)       /* standalone table */
+        pNode = (HASH_NODE *) symRomFind (name, type, mask);
+    else
+        {
+        /* fill in keySymbol */
+
+        keySymbol.name = name;          /* match this name */
+        keySymbol.type = type;          /* match this type */
 
-    pNode = hashTblFind (symTblId->nameHashId, &keySymbol.nameHNode, 
-                 (unsigned int) mask);
+        pNode = hashTblFind (symTblId->nameHashId,
+                             (HASH_NODE *) &keySymbol.nameHNode,
+                             (unsigned int) mask);
+        }
 
     if (pNode == NULL)
         {
@@ -372,51 +872,33 @@ int symFindSymbol
         {
     /* Search by value or by value and type: */
 
-    for (index = 0; index < symTblId->nameHashId->elements; index++)
+    if (symTblId->nameHashId == NULL)       /* standalone table */
+        {
+        pBestSymbol = symAddrFind (value, type, mask);
+        }
+    else
         {
-        pSymbol = 
-            (SYMBOL *) SLL_FIRST(&symTblId->nameHashId->pHashTbl [index]);
+        valueSrch.value       = value;
+        valueSrch.type        = type;
+        valueSrch.mask        = mask;
+        valueSrch.pBestSymbol = NULL;
 
-        while (pSymbol != NULL)         /* list empty */
-            {
-        if (((pSymbol->type & mask) == (type & mask)) &&
-            (pSymbol->value == value) &&
-            (((pUnder = strrchr (pSymbol->name, '_')) == NULL) ||
-             ((strcmp (pUnder, "_text") != 0) &&
-              (strcmp (pUnder, "_data") != 0) &&
-              (strcmp (pUnder, "_bss") != 0) &&
-              (strcmp (pUnder, "_compiled.") != 0))) &&
-            (((pUnder = strrchr (pSymbol->name, '.')) == NULL) ||
-             ((strcmp (pUnder, ".o") != 0))) &&
-            (!(pSymbol->type & SYM_ABS)))
+        pSymbol = (SYMBOL *) hashTblEach (symTblId->nameHashId,
+                                          (int (*) (HASH_NODE *, int))
+                                          symValueCheck, (int) &valueSrch);
+
+        if (pSymbol != NULL)
             {
             /* We've found the entry.  Return it. */
 
             *pSymbolId = pSymbol;
-            
             return OK;
             }
 
-        else if (((pSymbol->type & mask) == (type & mask)) &&
-             ((pSymbol->value <= value) &&
-              (pSymbol->value > bestValue)) &&
-             (!(pSymbol->type & SYM_ABS)))
-            {
-             
-            /* 
-             * This symbol is of correct type and closer than the last
-             * one 
-             */
-
-            bestValue   = pSymbol->value;
-            pBestSymbol = pSymbol;
-            }
-
-        pSymbol = (SYMBOL *) SLL_NEXT (&pSymbol->nameHNode);
-        }
+        pBestSymbol = valueSrch.pBestSymbol;
         }
 
-    if (bestValue == NULL || pBestSymbol == NULL) /* any closer symbol? */
+    if (pBestSymbol == NULL) /* any closer symbol? */
         {
         return ERROR;
         }
@@ -452,6 +934,7 @@ int symFind
     )
     {
     SYMBOL_ID   symbolId;       /* internal symbol description */
+    char        symName [MAX_SYS_SYM_LEN];  /* name of the symbol found */
     char *  name        = NULL;         /* default name */
     SYM_VALUE   value       = NULL;         /* default value */
     SYM_TYPE    type        = SYM_MASK_ANY_TYPE;    /* default type */
@@ -508,13 +991,15 @@ int symFind
         {
         unsigned int nameLen;       /* symbol name length */
 
+        (void) symNameCopy (symbolId, symName, sizeof (symName));
+
         /* Was a buffer provided to store the symbol name?  */
 
         if (pSymDesc->name == NULL)
             {
             /* No buffer provided: Must allocate one */
 
-        nameLen = strlen (symbolId->name) + 1;
+        nameLen = strlen (symName) + 1;
 
         /* Allocate room to store symbol name */
 
@@ -540,7 +1025,7 @@ int symFind
          * to store the symbol name, then the symbol name can be truncated.
          */
 
-        strncpy (pSymDesc->name, symbolId->name, nameLen);
+        strncpy (pSymDesc->name, symName, nameLen);
    
         pSymDesc->name[nameLen - 1] = EOS;
 
@@ -7,10 +7,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#define MAX_SYS_SYM_LEN         256        /* system symbols will not exceed this limit */
 #define N_EXT                   1          /* External symbol (OR'd in with one of above)  */
 
 extern SYMTAB_ID       sysSymTbl;                 /* system symbol table id */
+extern SYMBOL          standTbl[];                /* standalone symbol table */
+extern unsigned int    standTblSize;              /* symbols in standTbl */
+
+extern unsigned int    symRomLowerBound (const char * name);
+
+#define STR_MATCH_BITS          32         /* pattern chars found by bitap */
 
 typedef struct          /* RTN_DESC - routine descriptor */
     {
@@ -18,6 +23,21 @@ typedef struct          /* RTN_DESC - routine descriptor */
     int         routineArg;     /* user routine arg passed to symEach() */
     } RTN_DESC;
 
+typedef struct          /* PREFIX_DESC - routine descriptor, prefix filter */
+    {
+    RTN_DESC    rtnDesc;        /* user routine and argument */
+    const char * prefix;        /* name prefix */
+    int         prefixLen;      /* length of <prefix> */
+    } PREFIX_DESC;
+
+typedef struct          /* STR_MATCH - substring search pattern */
+    {
+    const char *    pattern;    /* string to find */
+    int             len;        /* length of <pattern> */
+    int             bitapLen;   /* chars of <pattern> found by bitap */
+    unsigned int    mask [256]; /* bitap masks: bit i clear if pattern[i] */
+    } STR_MATCH;
+
 /*******************************************************************************
 *
 * symEachRtn - call a user routine for a hashed symbol
@@ -69,6 +89,10 @@ LOCAL int symEachRtn
 * In addition to the parameters given, it also passes a pointer to a symbol
 * as the last arguement.
 *
+* The standalone table (no hash table) is walked in standTbl[] order, which
+* is sorted by name.  Its names are decoded one after the other into a
+* buffer of symEach(), which the routine may not keep.
+*
 */
 
 SYMBOL *symEach
@@ -80,41 +104,194 @@ SYMBOL *symEach
     {
     SYMBOL   *pSymbol;
     RTN_DESC rtnDesc;
+    unsigned int ix;
+    char     name [MAX_SYS_SYM_LEN];    /* standalone table symbol name */
 
     /* fill in a routine descriptor with the routine and argument to call */
 
     rtnDesc.routine    = routine;
     rtnDesc.routineArg = routineArg;
 
+    if (symTblId->nameHashId == NULL)
+        {
+        for (ix = 0; ix < standTblSize; ix++)
+            {
+            pSymbol = &standTbl[ix];
+
+            (void) symNameCopy (pSymbol, name, sizeof (name));
+
+            if (!(* routine) (name, (int) pSymbol->value, pSymbol->type,
+                              routineArg, pSymbol->group, pSymbol))
+                return (pSymbol);               /* symbol we stopped on */
+            }
+
+        return (NULL);
+        }
+
     pSymbol = (SYMBOL *) hashTblEach (symTblId->nameHashId, symEachRtn,
                                       (int) &rtnDesc);
 
     return (pSymbol);                           /* symbol we stopped on */
     }
 
+/*******************************************************************************
+*
+* symEachPrefixRtn - call a user routine for a hashed symbol with a prefix
+*
+* This routine supports hashTblEach() for symEachPrefix(): it calls the user
+* routine only if the name of <pSymbol> starts with the prefix.
+*
+* RETURNS: TRUE, or the result of the user routine.
+*
+* NOMANUAL
+*/
+
+LOCAL int symEachPrefixRtn
+    (
+    SYMBOL      *pSymbol,       /* ptr to symbol */
+    PREFIX_DESC *pPrefixDesc    /* ptr to a prefix routine descriptor */
+    )
+    {
+    if (strncmp (pSymbol->name, pPrefixDesc->prefix,
+                 pPrefixDesc->prefixLen) != 0)
+        return (TRUE);
+
+    return (symEachRtn (pSymbol, &pPrefixDesc->rtnDesc));
+    }
+
+/*******************************************************************************
+*
+* symEachPrefix - call a routine for each symbol starting with a prefix
+*
+* This routine is symEach() restricted to the symbols whose name starts with
+* <prefix>, as needed to list or complete symbol names.  The names of the
+* standalone table are sorted: its symbols with the prefix follow each other
+* from the lower bound of the prefix, found by binary search (see
+* symRomLowerBound()), so only they are visited.  A hashed table is walked
+* entirely.
+*
+* RETURNS: A pointer to the last symbol reached,
+* or NULL if all symbols with the prefix are reached.
+*/
+
+SYMBOL *symEachPrefix
+    (
+    SYMTAB_ID   symTblId,       /* pointer to symbol table */
+    char *      prefix,         /* name prefix */
+    FUNCPTR     routine,        /* func to call for each matching entry */
+    int         routineArg      /* arbitrary user-supplied arg */
+    )
+    {
+    SYMBOL      *pSymbol;
+    PREFIX_DESC prefixDesc;
+    unsigned int ix;
+    int         prefixLen = strlen (prefix);
+    char        name [MAX_SYS_SYM_LEN];    /* standalone table symbol name */
+
+    if (symTblId->nameHashId == NULL)
+        {
+        for (ix = symRomLowerBound (prefix); ix < standTblSize; ix++)
+            {
+            pSymbol = &standTbl[ix];
+
+            (void) symNameCopy (pSymbol, name, sizeof (name));
+
+            if (strncmp (name, prefix, prefixLen) != 0)
+                break;                          /* past the prefix */
+
+            if (!(* routine) (name, (int) pSymbol->value, pSymbol->type,
+                              routineArg, pSymbol->group, pSymbol))
+                return (pSymbol);               /* symbol we stopped on */
+            }
+
+        return (NULL);
+        }
+
+    prefixDesc.rtnDesc.routine    = routine;
+    prefixDesc.rtnDesc.routineArg = routineArg;
+    prefixDesc.prefix             = prefix;
+    prefixDesc.prefixLen          = prefixLen;
+
+    pSymbol = (SYMBOL *) hashTblEach (symTblId->nameHashId,
+                                      (int (*) (HASH_NODE *, int))
+                                      symEachPrefixRtn, (int) &prefixDesc);
+
+    return (pSymbol);                           /* symbol we stopped on */
+    }
+
+
+/*******************************************************************************
+*
+* strMatchInit - prepare a substring search
+*
+* This routine sets up <pMatch> to look for <pattern> with strMatch().  The
+* first STR_MATCH_BITS characters of the pattern are searched with the bitap
+* (shift-or) algorithm, which needs a mask per character value: bit i of
+* mask[c] is clear if pattern[i] is c.
+*
+* RETURNS: N/A
+*/
+
+LOCAL void strMatchInit
+    (
+    STR_MATCH *     pMatch,     /* search to set up */
+    const char *    pattern     /* string to find */
+    )
+    {
+    int     ix;
+
+    pMatch->pattern  = pattern;
+    pMatch->len      = strlen (pattern);
+    pMatch->bitapLen = (pMatch->len < STR_MATCH_BITS) ? pMatch->len :
+                       STR_MATCH_BITS;
+
+    for (ix = 0; ix < 256; ix++)
+        pMatch->mask [ix] = ~0U;
+
+    for (ix = 0; ix < pMatch->bitapLen; ix++)
+        pMatch->mask [(unsigned char) pattern [ix]] &= ~(1U << ix);
+    }
 
 /*******************************************************************************
 *
 * strMatch - find an occurrence of a string in another string
 *
-* This is a simple pattern matcher used by symPrint().  It looks for an
-* occurence of <str2> in <str1> and returns a pointer to that occurrence in
-* <str1>.  If it doesn't find one, it returns 0.
+* This is the pattern matcher used by symPrint().  It looks for an
+* occurence of the pattern of <pMatch> (see strMatchInit()) in <str> and
+* returns a pointer to that occurrence in <str>.  If it doesn't find one, it
+* returns 0.  Each character of <str> is read once: bit i of the state is
+* clear while the last i + 1 characters read are the start of the pattern.
+* The rest of a pattern longer than STR_MATCH_BITS is compared when its
+* start is found.
 */
 
 LOCAL char *strMatch
     (
-    FAST char *str1,            /* where to look for match */
-    FAST char *str2             /* string to find a match for */
+    FAST char *         str,    /* where to look for match */
+    const STR_MATCH *   pMatch  /* string to find a match for */
     )
     {
-    FAST int str2Length = strlen (str2);
-    FAST int ntries     = strlen (str1) - str2Length;
+    FAST unsigned int state = ~0U;
+    FAST unsigned int found;
+    FAST char *       pStart;
+
+    if (pMatch->len == 0)
+        return (str);
 
-    for (; ntries >= 0; str1++, --ntries)
+    found = 1U << (pMatch->bitapLen - 1);
+
+    for (; *str != EOS; str++)
         {
-        if (strncmp (str1, str2, str2Length) == 0)
-            return (str1);      /* we've found a match */
+        state = (state << 1) | pMatch->mask [(unsigned char) *str];
+
+        if ((state & found) == 0)
+            {
+            pStart = str - pMatch->bitapLen + 1;
+
+            if (strncmp (str + 1, pMatch->pattern + pMatch->bitapLen,
+                         pMatch->len - pMatch->bitapLen) == 0)
+                return (pStart);    /* we've found a match */
+            }
         }
 
     return (NULL);
@@ -125,8 +302,8 @@ LOCAL char *strMatch
 * symPrint - support routine for symShow()
 *
 * This routine is called by symEach() to deal with each symbol in the table.
-* If the symbol's name contains <substr>, this routine prints the symbol.
-* Otherwise, it doesn't.  If <substr> is NULL, every symbol is printed.
+* If the symbol's name contains the pattern of <pMatch>, this routine prints
+* the symbol.  Otherwise, it doesn't.
 */
 
 LOCAL int symPrint
@@ -134,12 +311,12 @@ LOCAL int symPrint
     char *      name,
     int         val,
     char        type,
-    char *      substr
+    STR_MATCH * pMatch
     )
     {
     char *      nameToPrint = name;
 
-    if (substr == NULL || strMatch (name, substr) != NULL)
+    if (strMatch (name, pMatch) != NULL)
         {
         printf ("%s 0x%x\n", nameToPrint, val);
         }
@@ -194,9 +371,9 @@ LOCAL const char * symTypeNameGet
 * symSysTblPrint - support routine for symShow()
 *
 * This routine is called by symEach() to deal with each symbol in the 
-* system symbol table.  If the symbol's name contains <substr>, this routine
-* prints the symbol.  Otherwise, it doesn't.  If <substr> is NULL, every
-* symbol is printed.  The type is printed along with the symbol value.
+* system symbol table.  If the symbol's name contains the pattern of
+* <pMatch>, this routine prints the symbol.  Otherwise, it doesn't.  The type
+* is printed along with the symbol value.
 */
 
 LOCAL int symSysTblPrint
@@ -204,13 +381,13 @@ LOCAL int symSysTblPrint
     char *      name,
     int         val,
     char        type,
-    char *      substr,
+    STR_MATCH * pMatch,
     unsigned short      group
     )
     {
     char *      nameToPrint = name;
 
-    if (substr == NULL || strMatch (name, substr) != NULL)
+    if (strMatch (name, pMatch) != NULL)
         {
         printf ("%-25s 0x%08x %-8s ", nameToPrint, val,
                 symTypeNameGet (type));
@@ -238,6 +415,9 @@ LOCAL int symSysTblPrint
 * symbols in the table will be listed.  If <substr> is NULL then the symbol
 * table structure will be summarized.
 *
+* If <substr> starts with '^', only the symbols whose names start with the
+* rest of it are listed; see symEachPrefix().
+*
 * RETURNS: OK, or ERROR if invalid symbol table id.
 *
 * SEE ALSO: symLib, symEach()
@@ -249,19 +429,37 @@ int symShow
     char *      substr          /* substring to match */
     )
     {
+    STR_MATCH   match;          /* substring search, "" after a prefix */
+    FUNCPTR     printRtn;
+
     if (substr == NULL)
         {
         printf ("%s: %d\n", "Number of Symbols", pSymTbl->nsymbols);
-        printf ("%s: 0x%x\n", "Symbol Hash Id",(int) pSymTbl->nameHashId);
+        if (pSymTbl->nameHashId == NULL)
+            printf ("%s: %s\n", "Symbol Hash Id", "ROM perfect hash");
+        else
+            {
+            printf ("%s: 0x%x\n", "Symbol Hash Id",(int) pSymTbl->nameHashId);
+            hashTblStats (pSymTbl->nameHashId);
+            }
         printf ("%s: %s\n", "Name Clash Policy", 
                 (pSymTbl->sameNameOk) ? "Allowed" : "Disallowed");
         }
     else
         {
-        if (pSymTbl == sysSymTbl)
-            symEach (pSymTbl, (FUNCPTR) symSysTblPrint, (int) substr);
+        printRtn = (pSymTbl == sysSymTbl) ? (FUNCPTR) symSysTblPrint :
+                                            (FUNCPTR) symPrint;
+
+        if (substr[0] == '^')
+            {
+            strMatchInit (&match, "");
+            symEachPrefix (pSymTbl, substr + 1, printRtn, (int) &match);
+            }
         else
-            symEach (pSymTbl, (FUNCPTR) symPrint, (int) substr);
+            {
+            strMatchInit (&match, substr);
+            symEach (pSymTbl, printRtn, (int) &match);
+            }
         }
 
     return (OK);
@@ -312,11 +312,13 @@ void command_boot(int argc, const char **argv)
             media_type = get_param_value("media_type", &ret);
             if (ret) {
                 printf("Can't get default 'media_type'\n");
+                cmd_status = -1;
                 return;
             }
             kernel_part = get_mtd_partition("kernel");
             if (kernel_part == NULL) {
                 printf("Can't find default 'kernel' partition\n");
+                cmd_status = -1;
                 return;
             }
             from = kernel_part->offset;
@@ -348,10 +350,11 @@ void command_boot(int argc, const char **argv)
             break;
     }
 
-    boot_kernel(from, size, media_type);
+    if (boot_kernel(from, size, media_type))
+        cmd_status = -1;
 }
 
-user_command_t boot_cmd = {
+USER_CMD(boot_cmd) = {
     "boot",
     command_boot,
     NULL,
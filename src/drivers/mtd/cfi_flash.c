@@ -23,12 +23,10 @@
  * but WITHOUT ANY WARRANTY; without even the implied warranty of
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  * GNU General Public License for more details.
- *
- *
- 
+ */
 
-/* The DEBUG define must be before common to enable debugging */
-#define DEBUG
+/* define CFI_DEBUG to trace the flash commands */
+/* #define CFI_DEBUG */
 
 #include "cfi_flash.h"
 #include <wrboot.h>
@@ -36,6 +34,17 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef CFI_DEBUG
+#define debug(fmt, args...)     printf(fmt, ##args)
+#else
+#define debug(fmt, args...)
+#endif
+
+#define CFI_MAX_TOUT_MS     30000   /* cap of the status check timeouts */
+
+extern struct mtd_info *mymtd;
+extern char *size_human_readable(unsigned long long size);
+
 #define __BIG_ENDIAN
 #define CFG_FLASH_EMPTY_INFO
 #define CONFIG_DRIVER_CFI_INTEL 1 
@@ -130,7 +139,7 @@ static int flash_write_cfiword(struct flash_info *info, unsigned long dest,
                     info->write_tout, "write");
 }
 
-#ifdef DEBUG
+#ifdef CFI_DEBUG
 static void flash_printqry(struct cfi_qry *qry)
 {
     u8 *p = (u8 *)qry;
@@ -180,10 +189,10 @@ static unsigned long flash_read_long(struct flash_info *info, flash_sect_t sect,
 
     addr = flash_make_addr (info, sect, offset);
 
-    printf("long addr is at %p info->portwidth = %d\n", addr,
+    debug("long addr is at %p info->portwidth = %d\n", addr,
            info->portwidth);
     for (x = 0; x < 4 * info->portwidth; x++)
-        printf("addr[%x] = 0x%x\n", x, flash_read8(addr + x));
+        debug("addr[%x] = 0x%x\n", x, flash_read8(addr + x));
 
 #if defined __LITTLE_ENDIAN
     retval = ((flash_read8(addr) << 16) |
@@ -259,19 +268,19 @@ static int flash_detect_width(struct flash_info *info, struct cfi_qry *qry)
         }
     }
 
-    printf("no flash found\n");
+    debug("no flash found\n");
 
     return -1;
 
 found:
     flash_read_cfi(info, qry, FLASH_OFFSET_CFI_RESP,
                    sizeof(struct cfi_qry));
-    info->interface = (&qry->interface_desc);
+    info->interface = le16_to_cpu(qry->interface_desc);
     info->cfi_offset = flash_offset_cfi[cfi_offset];
-    printf("device interface is %d\n", info->interface);
-    printf("found port %d chip %d chip_lsb %d ",
+    debug("device interface is %d\n", info->interface);
+    debug("found port %d chip %d chip_lsb %d ",
             info->portwidth, info->chipwidth, info->chip_lsb);
-    printf("port %d bits chip %d bits\n",
+    debug("port %d bits chip %d bits\n",
             info->portwidth << CFI_FLASH_SHIFT_WIDTH,
             info->chipwidth << CFI_FLASH_SHIFT_WIDTH);
 
@@ -282,7 +291,7 @@ static int flash_detect_cfi(struct flash_info *info, struct cfi_qry *qry)
 {
     int ret;
 
-    printf("flash detect cfi\n");
+    debug("flash detect cfi\n");
 
     info->chip_lsb = 0;
     ret = flash_detect_width (info, qry);
@@ -314,17 +323,17 @@ static int flash_detect_size(struct flash_info *info)
     info->cfi_version = 0;
 
     /* first only malloc space for the first sector */
-    info->start = xmalloc(sizeof(*info->eraseregions));
+    info->start = xmalloc(sizeof(*info->start));
 
     info->start[0] = base;
-	info->protect = 0;
+    info->protect = NULL;
 
     ret = flash_detect_cfi(info, &qry);
     if (ret)
         return ret;
 
-    info->vendor = (&qry.p_id);
-    info->ext_addr = (&qry.p_adr);
+    info->vendor = le16_to_cpu(qry.p_id);
+    info->ext_addr = le16_to_cpu(qry.p_adr);
     num_erase_regions = qry.num_erase_regions;
 
     if (info->ext_addr) {
@@ -334,7 +343,7 @@ static int flash_detect_size(struct flash_info *info)
                     info->ext_addr + 4);
     }
 
-#ifdef DEBUG
+#ifdef CFI_DEBUG
     flash_printqry(&qry);
 #endif
 
@@ -361,11 +370,11 @@ static int flash_detect_size(struct flash_info *info)
 
     info->cfi_cmd_set->flash_fixup (info, &qry);
 
-    printf("manufacturer is %d\n", info->vendor);
-    printf("manufacturer id is 0x%x\n", info->manufacturer_id);
-    printf("device id is 0x%x\n", info->device_id);
-    printf("device id2 is 0x%x\n", info->device_id2);
-    printf("cfi version is 0x%04x\n", info->cfi_version);
+    debug("manufacturer is %d\n", info->vendor);
+    debug("manufacturer id is 0x%x\n", info->manufacturer_id);
+    debug("device id is 0x%x\n", info->device_id);
+    debug("device id2 is 0x%x\n", info->device_id2);
+    debug("cfi version is 0x%04x\n", info->cfi_version);
 
     size_ratio = info->portwidth / info->chipwidth;
 
@@ -376,12 +385,29 @@ static int flash_detect_size(struct flash_info *info)
         size_ratio >>= 1;
     }
 
-    printf("size_ratio %d port %d bits chip %d bits\n",
+    debug("size_ratio %d port %d bits chip %d bits\n",
            size_ratio, info->portwidth << CFI_FLASH_SHIFT_WIDTH,
            info->chipwidth << CFI_FLASH_SHIFT_WIDTH);
-    printf("found %d erase regions\n", num_erase_regions);
+    debug("found %d erase regions\n", num_erase_regions);
+
+    if (num_erase_regions > NUM_ERASE_REGIONS) {
+        printf("%d erase regions found, only %d used\n",
+            num_erase_regions, NUM_ERASE_REGIONS);
+        num_erase_regions = NUM_ERASE_REGIONS;
+    }
 
-    info->eraseregions = calloc(sizeof(*info->eraseregions) * num_erase_regions);
+    /* size the sector tables, the first sector stays where it is */
+    sect_cnt = 0;
+    for (i = 0; i < num_erase_regions; i++)
+        sect_cnt += (le32_to_cpu(qry.erase_region_info[i]) & 0xffff) + 1;
+    kfree(info->start);
+    info->start = xmalloc(sizeof(*info->start) * sect_cnt);
+    info->protect = xmalloc(sizeof(*info->protect) * sect_cnt);
+    if (info->start == NULL || info->protect == NULL)
+        return -1;
+    info->start[0] = base;
+
+    info->eraseregions = calloc(num_erase_regions, sizeof(*info->eraseregions));
     info->numeraseregions = num_erase_regions;
     sect_cnt = 0;
     sector = base;
@@ -389,20 +415,14 @@ static int flash_detect_size(struct flash_info *info)
     for (i = 0; i < num_erase_regions; i++) {
         struct mtd_erase_region_info *region = &info->eraseregions[i];
 
-        if (i > NUM_ERASE_REGIONS) {
-            printf("%d erase regions found, only %d used\n",
-                num_erase_regions, NUM_ERASE_REGIONS);
-            break;
-        }
-
-        tmp = (&qry.erase_region_info[i]);
-        printf("erase region %u: 0x%08lx\n", i, tmp);
+        tmp = le32_to_cpu(qry.erase_region_info[i]);
+        debug("erase region %u: 0x%08lx\n", i, tmp);
 
         erase_region_count = (tmp & 0xffff) + 1;
         tmp >>= 16;
         erase_region_size =
             (tmp & 0xffff) ? ((tmp & 0xffff) * 256) : 128;
-        printf("erase_region_count = %d erase_region_size = %d\n",
+        debug("erase_region_count = %d erase_region_size = %d\n",
             erase_region_count, erase_region_size);
 
         region->offset = cur_offset;
@@ -410,14 +430,7 @@ static int flash_detect_size(struct flash_info *info)
         region->numblocks = erase_region_count;
         cur_offset += erase_region_size * size_ratio * erase_region_count;
 
-        /* increase the space malloced for the sector start addresses */
-#if 0
-        info->start = xrealloc(info->start, sizeof(*info->eraseregions) *
-                (erase_region_count + sect_cnt));
-        info->protect = xrealloc(info->protect, sizeof(*info->eraseregions) *
-                (erase_region_count + sect_cnt));
-#endif
-
+        /* the sector tables were sized above */
         for (j = 0; j < erase_region_count; j++) {
             info->start[sect_cnt] = sector;
             sector += (erase_region_size * size_ratio);
@@ -444,9 +457,7 @@ static int flash_detect_size(struct flash_info *info)
     info->sector_count = sect_cnt;
     /* multiply the size by the number of chips */
     info->size = (1 << qry.dev_size) * size_ratio;
-#if 0
-	info->buffer_size = (1 << (&qry.max_buf_write_size));
-#endif
+    info->buffer_size = (1 << le16_to_cpu(qry.max_buf_write_size));
     info->erase_blk_tout = 1 << (qry.block_erase_timeout_typ +
                      qry.block_erase_timeout_max);
     info->buffer_write_tout = 1 << (qry.buf_write_timeout_typ +
@@ -463,19 +474,21 @@ static int flash_detect_size(struct flash_info *info)
     return 0;
 }
 
-/* loop through the sectors from the highest address
- * when the passed address is greater or equal to the sector address
- * we have a match
+/* the erase block holding the address; addresses past the end give
+ * the last sector
  */
 flash_sect_t find_sector(struct flash_info *info, unsigned long addr)
 {
-    flash_sect_t sector;
+    u_int32_t start, size;
+    int sector;
 
-    for (sector = info->sector_count - 1; sector >= 0; sector--) {
-        if (addr >= info->start[sector])
-            break;
-    }
+    if (addr < (unsigned long)info->base)
+        return 0;
 
+    sector = mtd_block(&info->mtd, addr - (unsigned long)info->base,
+                       &start, &size);
+    if (sector < 0)
+        return info->sector_count ? info->sector_count - 1 : 0;
     return sector;
 }
 
@@ -484,7 +497,7 @@ static int cfi_erase(struct flash_info *finfo, size_t count, loff_t offset)
         unsigned long start, end;
         int i, ret = 0;
 
-    printf("%s: erase 0x%08llx (size %zu)\n", __func__, offset, count);
+    debug("%s: erase 0x%08llx (size %zu)\n", __func__, offset, count);
 
         start = find_sector(finfo, (unsigned long)finfo->base + offset);
         end   = find_sector(finfo, (unsigned long)finfo->base + offset +
@@ -666,24 +679,16 @@ static int cfi_mtd_protect(struct flash_info *finfo, loff_t offset, size_t len,
 
 static int cfi_mtd_lock(struct mtd_info *mtd, loff_t offset, size_t len)
 {
-#if 0
-    struct flash_info *finfo = container_of(mtd, struct flash_info, mtd);
+    struct flash_info *finfo = mtd->priv;
 
     return cfi_mtd_protect(finfo, offset, len, 1);
-#else
-	return 0;
-#endif
 }
 
 static int cfi_mtd_unlock(struct mtd_info *mtd, loff_t offset, size_t len)
 {
-#if 0
-    struct flash_info *finfo = container_of(mtd, struct flash_info, mtd);
+    struct flash_info *finfo = mtd->priv;
 
     return cfi_mtd_protect(finfo, offset, len, 0);
-#else
-    return 0;
-#endif
 }
 
 static void cfi_info_one(struct flash_info *info)
@@ -804,15 +809,17 @@ int flash_status_check(struct flash_info *info, flash_sect_t sector,
 int flash_generic_status_check(struct flash_info *info, flash_sect_t sector,
                    u64 tout, char *prompt)
 {
-    u64 start;
+    u32 start, ticks;
 
-        tout *= 1000000;
+    /* tout is in ms, the tick count must fit in 32 bits */
+    if (tout > CFI_MAX_TOUT_MS)
+        tout = CFI_MAX_TOUT_MS;
+    ticks = (u32)tout * (sysTimeBaseFreqGet() / 1000);
 
     /* Wait for command completion */
-#if 0
-    start = get_time_ns();
+    start = sysTimeBaseLGet();
     while (info->cfi_cmd_set->flash_is_busy (info, sector)) {
-        if (is_timeout(start, tout)) {
+        if (sysTimeBaseLGet() - start >= ticks) {
             printf("Flash %s timeout at address %lx data %lx\n",
                 prompt, info->start[sector],
                 flash_read_long (info, sector, 0));
@@ -821,9 +828,7 @@ int flash_generic_status_check(struct flash_info *info, flash_sect_t sector,
 
             return -1;
         }
-        udelay(1);      /* also triggers watchdog */
     }
-#endif
     return 0;
 }
 
@@ -852,7 +857,7 @@ void flash_write_cmd(struct flash_info *info, flash_sect_t sect,
     addr = flash_make_addr (info, sect, offset);
     flash_make_cmd (info, cmd, &cword);
 
-    printf("%s: %p %lX %X => %p " CFI_WORD_FMT "\n", __func__,
+    debug("%s: %p %lX %X => %p " CFI_WORD_FMT "\n", __func__,
             info, sect, offset, addr, cword);
 
     flash_write_word(info, cword, addr);
@@ -868,19 +873,19 @@ int flash_isequal(struct flash_info *info, flash_sect_t sect,
     addr = flash_make_addr (info, sect, offset);
     flash_make_cmd (info, cmd, &cword);
 
-    printf("is= cmd %x(%c) addr %p ", cmd, cmd, addr);
+    debug("is= cmd %x(%c) addr %p ", cmd, cmd, addr);
 
     if (bankwidth_is_1(info)) {
-        printf("is= %x %x\n", flash_read8(addr), (u8)cword);
+        debug("is= %x %x\n", flash_read8(addr), (u8)cword);
         retval = (flash_read8(addr) == cword);
     } else if (bankwidth_is_2(info)) {
-        printf("is= %4.4x %4.4x\n", flash_read16(addr), (u16)cword);
+        debug("is= %4.4x %4.4x\n", flash_read16(addr), (u16)cword);
         retval = (flash_read16(addr) == cword);
     } else if (bankwidth_is_4(info)) {
-        printf("is= %8.8x %8.8x\n", flash_read32(addr), (u32)cword);
+        debug("is= %8.8x %8.8x\n", flash_read32(addr), (u32)cword);
         retval = (flash_read32(addr) == cword);
     } else if (bankwidth_is_8(info)) {
-        printf("is= %16.16llx %16.16llx\n", flash_read64(addr), (u64)cword);
+        debug("is= %16.16llx %16.16llx\n", flash_read64(addr), (u64)cword);
         retval = (flash_read64(addr) == cword);
     } else {
         retval = 0;
@@ -912,35 +917,50 @@ int flash_isset(struct flash_info *info, flash_sect_t sect,
     return retval;
 }
 
+/* the flash is mapped cache-inhibited: one load per word, no bursts */
+FAST_FUNC static void flash_copy(u8 *dst, const u8 *src, size_t len)
+{
+    const volatile u32 *s = (const volatile u32 *)src;
+    u32 *d = (u32 *)dst;
+
+    if ((((unsigned long)dst | (unsigned long)src) & 3) == 0) {
+        for (; len >= 32; len -= 32, s += 8, d += 8) {
+            d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3];
+            d[4] = s[4]; d[5] = s[5]; d[6] = s[6]; d[7] = s[7];
+        }
+        for (; len >= 4; len -= 4)
+            *d++ = *s++;
+    }
+    src = (const u8 *)s;
+    dst = (u8 *)d;
+    while (len--)
+        *dst++ = *(const volatile u8 *)src++;
+}
+
 static int cfi_mtd_read(struct mtd_info *mtd, loff_t from, size_t len,
         size_t *retlen, u8 *buf)
 {
-#if 0
-    struct flash_info *info = container_of(mtd, struct flash_info, mtd);
+    struct flash_info *info = mtd->priv;
 
-    memcpy(buf, info->base + from, len);
+    flash_copy(buf, (u8 *)info->base + from, len);
     *retlen = len;
-#endif
     return 0;
 }
 
 static int cfi_mtd_write(struct mtd_info *mtd, loff_t to, size_t len,
         size_t *retlen, const u8 *buf)
 {
+    struct flash_info *info = mtd->priv;
     int ret;
-#if 0
-    struct flash_info *info = container_of(mtd, struct flash_info, mtd);
 
     ret = write_buff(info, buf, (unsigned long)info->base + to, len);
-    *retlen = len;
-#endif
-        return ret;
+    *retlen = ret ? 0 : len;
+    return ret;
 }
 
 static int cfi_mtd_erase(struct mtd_info *mtd, struct erase_info *instr)
 {
-#if 0
-    struct flash_info *info = container_of(mtd, struct flash_info, mtd);
+    struct flash_info *info = mtd->priv;
     int ret;
 
     ret = cfi_erase(info, instr->len, instr->addr);
@@ -949,18 +969,66 @@ static int cfi_mtd_erase(struct mtd_info *mtd, struct erase_info *instr)
         return -1;
     }
     instr->state = MTD_ERASE_DONE;
-    mtd_erase_callback(instr);
-#endif
     return 0;
 }
 
+/*
+ * Non-blocking erase and program, see erase_start() in mtd.h
+ */
+static int cfi_mtd_erase_start(struct mtd_info *mtd, loff_t ofs)
+{
+    struct flash_info *info = mtd->priv;
+
+    return info->cfi_cmd_set->flash_erase_start(info,
+            find_sector(info, (unsigned long)info->base + ofs));
+}
+
+/* start one write buffer, up to the next buffer boundary */
+static int cfi_mtd_write_start(struct mtd_info *mtd, loff_t to, size_t len,
+        size_t *retlen, const u8 *buf)
+{
+    struct flash_info *info = mtd->priv;
+    unsigned long wp = (unsigned long)info->base + to;
+    int buffered_size = (info->portwidth / info->chipwidth) * info->buffer_size;
+    size_t n;
+    int ret;
+
+    n = buffered_size - (wp % buffered_size);
+    if (n > len)
+        n = len;
+    n &= ~(info->portwidth - 1);
+
+    /* unaligned ends are a word or two, write them synchronously */
+    if ((wp & (info->portwidth - 1)) || n == 0) {
+        n = info->portwidth - (wp & (info->portwidth - 1));
+        if (n > len)
+            n = len;
+        ret = write_buff(info, buf, wp, n);
+        *retlen = ret ? 0 : n;
+        return ret;
+    }
+
+    ret = info->cfi_cmd_set->flash_write_cfibuffer_start(info, wp, buf, n);
+    *retlen = ret ? 0 : n;
+    return ret;
+}
+
+static int cfi_mtd_busy(struct mtd_info *mtd, loff_t ofs)
+{
+    struct flash_info *info = mtd->priv;
+
+    return info->cfi_cmd_set->flash_is_busy(info,
+            find_sector(info, (unsigned long)info->base + ofs));
+}
+
 static void cfi_init_mtd(struct flash_info *info)
 {
-#if 0
     struct mtd_info *mtd = &info->mtd;
     u32 erasesize;
     int i;
 
+    memset(mtd, 0, sizeof(*mtd));
+    mtd->name = "nor";
     mtd->read = cfi_mtd_read;
     mtd->write = cfi_mtd_write;
     mtd->erase = cfi_mtd_erase;
@@ -968,6 +1036,15 @@ static void cfi_init_mtd(struct flash_info *info)
     mtd->unlock = cfi_mtd_unlock;
     mtd->size = info->size;
 
+    /* only the AMD command set can start a command without waiting */
+    if (info->cfi_cmd_set->flash_erase_start &&
+        info->cfi_cmd_set->flash_write_cfibuffer_start &&
+        info->buffer_size > 1) {
+        mtd->erase_start = cfi_mtd_erase_start;
+        mtd->write_start = cfi_mtd_write_start;
+        mtd->busy = cfi_mtd_busy;
+    }
+
     erasesize = 0;
     for (i = 0; i < info->numeraseregions; i++) {
         if (erasesize < info->eraseregions[i].erasesize)
@@ -975,16 +1052,11 @@ static void cfi_init_mtd(struct flash_info *info)
     }
 
     mtd->erasesize = erasesize;
-
-    mtd->writesize = 1;
-    mtd->writebufsize = info->buffer_size;
-    mtd->subpage_sft = 0;
     mtd->eraseregions = info->eraseregions;
     mtd->numeraseregions = info->numeraseregions;
     mtd->flags = MTD_CAP_NORFLASH;
     mtd->type = MTD_NORFLASH;
-    mtd->parent = info->dev;
-#endif
+    mtd->priv = info;
 }
 
 static int cfi_probe_one(struct flash_info *info, int num)
@@ -994,12 +1066,12 @@ static int cfi_probe_one(struct flash_info *info, int num)
     info->flash_id = FLASH_UNKNOWN;
     info->cmd_reset = FLASH_CMD_RESET;
 
-    info->base = 0xff000000;
+    info->base = (void *)0xff000000;
 
     ret = flash_detect_size(info);
     if (ret) {
         printf("## Unknown FLASH on Bank at 0x%p - Size = 0x%08lx = %ld MB\n",
-            info->base, info->size, info->size << 20);
+            info->base, info->size, info->size >> 20);
         return -1;
     }
 
@@ -1011,15 +1083,22 @@ static int cfi_probe_one(struct flash_info *info, int num)
     return 0;
 }
 
-int cfi_probe_nor_flash()
+/*
+ * Probe the NOR flash of the board and register it as the MTD device
+ */
+int cfi_probe_nor_flash(void)
 {
     struct cfi_priv *priv;
     int i, ret;
 
-    priv = calloc(sizeof(*priv));
+    priv = calloc(1, sizeof(*priv));
+    if (priv == NULL)
+        return -1;
     priv->num_devs = 1;
 
-    priv->infos = calloc(sizeof(*priv->infos) * priv->num_devs);
+    priv->infos = calloc(priv->num_devs, sizeof(*priv->infos));
+    if (priv->infos == NULL)
+        return -1;
 
     for (i = 0; i < priv->num_devs; i++) {
         struct flash_info *info = &priv->infos[i];
@@ -1028,6 +1107,9 @@ int cfi_probe_nor_flash()
         if (ret)
             return ret;
     }
+
+    /* only one chip, no concatenation */
+    mymtd = &priv->infos[0].mtd;
     return 0;
 }
 #if 0
@@ -28,6 +28,10 @@
 
 typedef unsigned long flash_sect_t;
 
+/* P2020RDB: one x16 S29GL on the 16-bit local bus, with a write buffer */
+#define CONFIG_DRIVER_CFI_BANK_WIDTH_2
+#define CONFIG_CFI_BUFFER_WRITE
+
 #if   defined(CONFIG_DRIVER_CFI_BANK_WIDTH_8)
 typedef u64 cfiword_t;
 #define CFI_WORD_FMT    "0x%016llx"
@@ -77,7 +81,7 @@ struct flash_info {
     unsigned long addr_unlock1; /* unlock address 1 for AMD flash roms  */
     unsigned long addr_unlock2; /* unlock address 2 for AMD flash roms  */
     struct cfi_cmd_set *cfi_cmd_set;
-//    struct mtd_info mtd;
+    struct mtd_info mtd;
     int numeraseregions;
     struct mtd_erase_region_info *eraseregions;
     void *base;
@@ -122,6 +126,10 @@ struct cfi_cmd_set {
     int (*flash_write_cfibuffer)(struct flash_info *info, unsigned long dest,
             const u8 *cp, int len);
     int (*flash_erase_one)(struct flash_info *info, long sect);
+    /* optional: start an erase or a buffer write, do not wait for it */
+    int (*flash_erase_start)(struct flash_info *info, long sect);
+    int (*flash_write_cfibuffer_start)(struct flash_info *info,
+            unsigned long dest, const u8 *cp, int len);
     int (*flash_is_busy)(struct flash_info *info, flash_sect_t sect);
     void (*flash_read_jedec_ids)(struct flash_info *info);
     void (*flash_prepare_write)(struct flash_info *info);
@@ -257,19 +265,27 @@ int flash_isequal(struct flash_info *info, flash_sect_t sect,
                 unsigned int offset, u32 cmd);
 void flash_make_cmd(struct flash_info *info, u32 cmd, cfiword_t *cmdbuf);
 
+/* boot/cpu/ppc/util.S, address first */
+extern u8 readb(void *addr);
+extern u16 readw(void *addr);
+extern u32 readl(void *addr);
+extern void writeb(void *addr, u8 val);
+extern void writew(void *addr, u16 val);
+extern void writel(void *addr, u32 val);
+
 static inline void flash_write8(u8 value, void *addr)
 {
-    writeb(value, addr);
+    writeb(addr, value);
 }
 
 static inline void flash_write16(u16 value, void *addr)
 {
-    writew(value, addr);
+    writew(addr, value);
 }
 
 static inline void flash_write32(u32 value, void *addr)
 {
-    writel(value, addr);
+    writel(addr, value);
 }
 
 static inline void flash_write64(u64 value, void *addr)
@@ -311,6 +327,17 @@ static inline u8 *flash_make_addr(struct flash_info *info, flash_sect_t sect,
 u8 flash_read_uchar(struct flash_info *info, unsigned int offset);
 u32 jedec_read_mfr(struct flash_info *info);
 
+/* the CFI query structure is little endian */
+static inline u16 le16_to_cpu(u16 x)
+{
+    return (x >> 8) | (x << 8);
+}
+
+static inline u32 le32_to_cpu(u32 x)
+{
+    return (x >> 24) | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000) | (x << 24);
+}
+
 #ifdef CONFIG_DRIVER_CFI_BANK_WIDTH_1
 #define bankwidth_is_1(info) (info->portwidth == 1)
 #else
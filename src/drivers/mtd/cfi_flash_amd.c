@@ -109,13 +109,20 @@ static int amd_flash_is_busy(struct flash_info *info, flash_sect_t sect)
 	return flash_toggle (info, sect, 0, AMD_STATUS_TOGGLE);
 }
 
-static int amd_flash_erase_one(struct flash_info *info, long sect)
+static int amd_flash_erase_start(struct flash_info *info, long sect)
 {
 	flash_unlock_seq(info);
 	flash_write_cmd (info, 0, info->addr_unlock1, AMD_CMD_ERASE_START);
 	flash_unlock_seq(info);
 	flash_write_cmd (info, sect, 0, AMD_CMD_ERASE_SECTOR);
 
+	return 0;
+}
+
+static int amd_flash_erase_one(struct flash_info *info, long sect)
+{
+	amd_flash_erase_start(info, sect);
+
 	return flash_status_check(info, sect, info->erase_blk_tout, "erase");
 }
 
@@ -126,8 +133,8 @@ static void amd_flash_prepare_write(struct flash_info *info)
 }
 
 #ifdef CONFIG_CFI_BUFFER_WRITE
-static int amd_flash_write_cfibuffer(struct flash_info *info, unsigned long dest,
-		const u8 *cp, int len)
+static int amd_flash_write_cfibuffer_start(struct flash_info *info,
+		unsigned long dest, const u8 *cp, int len)
 {
 	flash_sect_t sector;
 	int cnt;
@@ -173,11 +180,20 @@ static int amd_flash_write_cfibuffer(struct flash_info *info, unsigned long dest
 
 	flash_write_cmd(info, sector, 0, AMD_CMD_WRITE_BUFFER_CONFIRM);
 
-	return flash_status_check(info, sector, info->buffer_write_tout,
-					   "buffer write");
+	return 0;
+}
+
+static int amd_flash_write_cfibuffer(struct flash_info *info, unsigned long dest,
+		const u8 *cp, int len)
+{
+	amd_flash_write_cfibuffer_start(info, dest, cp, len);
+
+	return flash_status_check(info, find_sector(info, dest),
+					   info->buffer_write_tout, "buffer write");
 }
 #else
 #define amd_flash_write_cfibuffer NULL
+#define amd_flash_write_cfibuffer_start NULL
 #endif /* CONFIG_CFI_BUFFER_WRITE */
 
 static int amd_flash_real_protect(struct flash_info *info, long sector, int prot)
@@ -259,6 +275,8 @@ static void amd_flash_fixup(struct flash_info *info, struct cfi_qry *qry)
 struct cfi_cmd_set cfi_cmd_set_amd = {
 	.flash_write_cfibuffer = amd_flash_write_cfibuffer,
 	.flash_erase_one = amd_flash_erase_one,
+	.flash_erase_start = amd_flash_erase_start,
+	.flash_write_cfibuffer_start = amd_flash_write_cfibuffer_start,
 	.flash_is_busy = amd_flash_is_busy,
 	.flash_read_jedec_ids = amd_read_jedec_ids,
 	.flash_prepare_write = amd_flash_prepare_write,
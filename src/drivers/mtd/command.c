@@ -45,9 +45,21 @@
 #include <string.h>
 #include <types.h>
 #include <command.h>
+#include <hashLib.h>
 
-static user_command_t *head_cmd = NULL;
-static user_command_t *tail_cmd = NULL;
+/*
+ * Command index: the descriptors of the .wrboot_cmd section, plus the
+ * ones added by add_command(), chained through next_cmd in a hash table
+ * keyed on the FNV-1a hash of the name.  It is built on the first lookup.
+ */
+#define CMD_HASH_SIZE       64      /* power of 2 */
+#define CMD_HASH_SEED       0
+#define CMD_LINE_MAX        256
+
+static user_command_t *cmd_hash[CMD_HASH_SIZE];
+static int cmd_hash_ready = 0;
+
+int cmd_status = 0;
 
 /*
  * Parse user command line
@@ -97,7 +109,7 @@ void parseargs(char *argstr, int *argc_p, char **argv, char** resid)
         argstr++;
     }
 
-#if 1 /* for debugging */
+#if 0 /* for debugging */
     {
         int i;
         printf("parseargs: argc=", argc);
@@ -139,63 +151,179 @@ void unparseargs(char *argstr, int argc, const char **argv)
  * For (main) commands
  */
 
-/* add user command */
-void add_command(user_command_t *cmd)
+static unsigned int cmd_hash_index(const char *name)
 {
-    if (head_cmd == NULL) {
-        head_cmd = tail_cmd = cmd;
-    } else {
-        tail_cmd->next_cmd = cmd;
-        tail_cmd = cmd;
-    }
-    printf("Registered '%s' command\n", cmd->name);
+    return hashStrFnv1a(name, CMD_HASH_SEED) & (CMD_HASH_SIZE - 1);
 }
 
-/* find command */
-user_command_t *find_cmd(const char *cmdname)
+static user_command_t *cmd_hash_lookup(const char *cmdname)
 {
     user_command_t *curr;
 
-    /* do da string compare for the first offset character of cmdstr
-      against each number of the cmdlist */
-    curr = head_cmd;
-    while(curr != NULL) {
-        if (strncmp(curr->name, cmdname, strlen(cmdname)) == 0)
+    curr = cmd_hash[cmd_hash_index(cmdname)];
+    while (curr != NULL) {
+        if (strcmp(curr->name, cmdname) == 0)
             return curr;
         curr = curr->next_cmd;
     }
     return NULL;
 }
 
+static void cmd_hash_insert(user_command_t *cmd)
+{
+    unsigned int ix = cmd_hash_index(cmd->name);
+
+    cmd->next_cmd = cmd_hash[ix];
+    cmd_hash[ix] = cmd;
+}
+
+/* index the commands registered at link time */
+static void cmd_hash_init(void)
+{
+    user_command_t *cmd;
+
+    cmd_hash_ready = 1;
+    for (cmd = wrboot_cmd_start; cmd < wrboot_cmd_end; cmd++) {
+        if (cmd_hash_lookup(cmd->name) != NULL) {
+            printf("Duplicated '%s' command\n", cmd->name);
+            continue;
+        }
+        cmd_hash_insert(cmd);
+    }
+}
+
+/* add user command at run time */
+void add_command(user_command_t *cmd)
+{
+    if (!cmd_hash_ready)
+        cmd_hash_init();
+    if (cmd_hash_lookup(cmd->name) != NULL)
+        return;
+    cmd_hash_insert(cmd);
+}
+
+/* find a command by its full name only */
+static user_command_t *find_cmd_exact(const char *cmdname)
+{
+    if (!cmd_hash_ready)
+        cmd_hash_init();
+    return cmd_hash_lookup(cmdname);
+}
+
+/*
+ * find command: an exact match through the index, or else a name
+ * abbreviation, as long as it is not ambiguous
+ */
+user_command_t *find_cmd(const char *cmdname)
+{
+    user_command_t *curr, *found = NULL;
+    size_t len = strlen(cmdname);
+    int i;
+
+    if (len == 0)
+        return NULL;
+
+    curr = find_cmd_exact(cmdname);
+    if (curr != NULL)
+        return curr;
+
+    for (i = 0; i < CMD_HASH_SIZE; i++) {
+        for (curr = cmd_hash[i]; curr != NULL; curr = curr->next_cmd) {
+            if (strncmp(curr->name, cmdname, len) != 0)
+                continue;
+            if (found != NULL) {
+                printf("Ambiguous command '%s'\n", cmdname);
+                return NULL;
+            }
+            found = curr;
+        }
+    }
+    return found;
+}
+
 /* execute a function */
-void execcmd(int argc, const char **argv)
+int execcmd(int argc, const char **argv)
 {
     user_command_t *cmd = find_cmd(argv[0]);
 
     if (cmd == NULL) {
         printf("Could not found '%s' command\n", argv[0]);
         printf("If you want to konw available commands, type 'help'\n"); 
-        return;
+        cmd_status = -1;
+        return cmd_status;
     }
-    printf("execcmd: cmd=%s, argc=%d\n", argv[0], argc);
 
+    cmd_status = 0;
     cmd->cmdfunc(argc, argv);
+    return cmd_status;
 }
 
-/* parse and execute a string */
-void exec_string(char *buf)
+/*
+ * parse and execute a string
+ *
+ * Statements are separated by ';'.  Inside a statement, a command after
+ * "&&" only runs if the previous one succeeded, and one after "||" only
+ * if it failed, as in sh.  Returns the status of the last command run.
+ */
+int exec_string(char *buf)
 {
     int argc;
     char *argv[128];
     char *resid;
+    int i, start;
+    char cond, next;
 
+    cmd_status = 0;
     while (*buf) {
         memset(argv, 0, sizeof(argv));
         parseargs(buf, &argc, argv, &resid);
-        if (argc > 0)
-            execcmd(argc, (const char **)argv);
+        cond = 0;
+        for (start = 0, i = 0; i <= argc; i++) {
+            if (i < argc && strcmp(argv[i], "&&") != 0 &&
+                    strcmp(argv[i], "||") != 0)
+                continue;
+            next = (i < argc) ? argv[i][0] : 0;
+            argv[i] = NULL;     /* terminate argv of this command */
+            if (i > start && (cond == 0 ||
+                    (cond == '&' && cmd_status == 0) ||
+                    (cond == '|' && cmd_status != 0)))
+                execcmd(i - start, (const char **)(argv + start));
+            cond = next;
+            start = i + 1;
+        }
         buf = resid;
     }
+    return cmd_status;
+}
+
+/*
+ * Run a command line if its first word is the full name of a command.
+ * Returns 0, or -1 when the line is not a command (left to the caller,
+ * e.g. to call a symbol).  Abbreviations are not tried here: short
+ * symbol names would run, or be reported as ambiguous, commands.
+ */
+int cmd_dispatch(const char *line)
+{
+    char buf[CMD_LINE_MAX];
+    char name[32];
+    size_t len;
+
+    while (*line == ' ' || *line == '\t')
+        line++;
+    for (len = 0; line[len] && line[len] != ' ' && line[len] != '\t' &&
+            line[len] != ';'; len++)
+        ;
+    if (len == 0 || len >= sizeof(name))
+        return -1;
+    memcpy(name, line, len);
+    name[len] = '\0';
+    if (find_cmd_exact(name) == NULL)
+        return -1;
+
+    strncpy(buf, line, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    exec_string(buf);
+    return 0;
 }
 
 /*
@@ -206,13 +334,13 @@ void execsubcmd(user_subcommand_t *cmds, int argc, const char **argv)
 
     while (cmds->name != NULL) {
         if (strncmp(argv[0], cmds->name, strlen(argv[0])) == 0) {
-            printf("subexeccmd: cmd=%s, argc=%d\n", argv[0], argc);
             cmds->cmdfunc(argc, argv);
             return;
         }
         cmds++;
     }
     printf("Could not found '%s' sub-command\n", argv[0]);
+    cmd_status = -1;
 }
 
 void print_usage(char *strhead, user_subcommand_t *cmds)
@@ -231,6 +359,7 @@ void invalid_cmd(const char *cmd_name, user_subcommand_t *cmds)
 {
     printf("invalid '%s' command: wrong argumets\n", cmd_name);
     print_usage("  ", cmds);
+    cmd_status = -1;
 }
 
 
@@ -257,6 +386,7 @@ void invalid_cmd(const char *cmd_name, user_subcommand_t *cmds)
 void command_help(int argc, const char **argv)
 {
     user_command_t *curr;
+    int i;
 
     /* help <command>. invoke <command> with 'help' as an argument */
     if (argc == 2) {
@@ -271,14 +401,21 @@ void command_help(int argc, const char **argv)
     }
 
     printf("Usage:\n");
-    curr = head_cmd;
-    while(curr != NULL) {
+    for (curr = wrboot_cmd_start; curr < wrboot_cmd_end; curr++)
         printf("   %s\n", curr->helpstr);
-        curr = curr->next_cmd;
+
+    /* then the ones added at run time */
+    if (!cmd_hash_ready)
+        cmd_hash_init();
+    for (i = 0; i < CMD_HASH_SIZE; i++) {
+        for (curr = cmd_hash[i]; curr != NULL; curr = curr->next_cmd) {
+            if (curr < wrboot_cmd_start || curr >= wrboot_cmd_end)
+                printf("   %s\n", curr->helpstr);
+        }
     }
 }
 
-user_command_t help_cmd = {
+USER_CMD(help_cmd) = {
     "help",
     command_help,
     NULL,
@@ -301,80 +438,9 @@ void command_dump(int argc, const char *argv[])
     hexdump(p, num);
 }
 
-user_command_t dump_cmd = {
+USER_CMD(dump_cmd) = {
     "dump",
     command_dump,
     NULL,
     "dump <addr> <length> \t\t-- Display (hex dump) a range of memory."
 };
-
-extern user_command_t boot_cmd;
-#ifdef CONFIG_CMD_MEM
-extern user_command_t mem_cmd;
-#endif
-extern user_command_t load_cmd;
-extern user_command_t reset_cmd;
-extern user_command_t go_cmd;
-extern user_command_t call_cmd;
-#ifdef CONFIG_CMD_PART
-extern user_command_t part_cmd;
-#endif
-#ifdef CONFIG_CMD_PARAM
-extern user_command_t param_cmd;
-#endif
-#ifdef CONFIG_CMD_SLEEP
-extern user_command_t sleep_cmd;
-#endif
-#ifdef CONFIG_CMD_BONFS
-extern user_command_t bon_cmd;
-#endif
-#ifdef CONFIG_CMD_PROMPT
-extern user_command_t prompt_cmd;
-#endif
-#ifdef CONFIG_TEST
-extern user_command_t test_cmd;
-#endif
-#ifdef CONFIG_CMD_AMD_FLASH
-extern user_command_t amd_cmd;
-#endif
-
-/* Register basic user commands */
-int init_builtin_cmds(void)
-{
-#ifdef CONFIG_DEBUG
-    printf("init built-in commands\n");
-#endif
-
-#ifdef CONFIG_CMD_AMD_FLASH
-    add_command(&amd_cmd);
-#endif
-#ifdef CONFIG_TEST
-    add_command(&test_cmd);
-#endif
-#ifdef CONFIG_CMD_PROMPT
-    add_command(&prompt_cmd);
-#endif
-#ifdef CONFIG_CMD_SLEEP
-    add_command(&sleep_cmd);
-#endif
-#ifdef CONFIG_CMD_BONFS
-    add_command(&bon_cmd);
-#endif
-    add_command(&reset_cmd);
-#ifdef CONFIG_CMD_PARAM
-    add_command(&param_cmd);
-#endif
-#ifdef CONFIG_CMD_PART
-    add_command(&part_cmd);
-#endif
-#ifdef CONFIG_CMD_MEM
-    add_command(&mem_cmd);
-#endif
-    add_command(&load_cmd);
-    add_command(&go_cmd);
-    add_command(&dump_cmd);
-    add_command(&call_cmd);
-    add_command(&boot_cmd);
-    add_command(&help_cmd);
-    return 0;
-}
@@ -148,14 +148,14 @@ void command_go(int argc, const char **argv)
 }
 
 
-user_command_t go_cmd = {
+USER_CMD(go_cmd) = {
     "go",
     command_go,
     NULL,
     "go <addr> <a0> <a1> <a2> <a3> \t-- jump to <addr>"
 };
 
-user_command_t call_cmd = {
+USER_CMD(call_cmd) = {
     "call",
     command_call,
     NULL,
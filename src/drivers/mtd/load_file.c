@@ -25,6 +25,9 @@
 #include <stdlib.h>
 #include <wrboot.h>
 #include <types.h>
+#include "mtd.h"
+
+extern struct mtd_info *mymtd;
 
 static int modem_is(const char *mt)
 {
@@ -41,23 +44,18 @@ static int modem_is(const char *mt)
 
 static u32 download_file(char *buf, size_t size, int modem)
 {
+    long len;
+
     switch (modem) {
         case X_MODEM:
-            printf("Ready for downloading using xmodem...\n");
-            printf("Waiting...\n");
-//            return xmodem_receive(buf, size);
-            break;
         case Y_MODEM:
-            printf("Not support ymodem yet. Using xmodem\n");
-            printf("Ready for downling using xmodem\n");
+            printf("Ready for downloading using %cmodem...\n",
+                (modem == X_MODEM) ? 'x' : 'y');
             printf("Waiting...\n");
-//            return xmodem_receive(buf, size);
-            break;
+            len = xmodem_receive(buf, size);
+            return (len < 0) ? 0 : len;
         case Z_MODEM:
-            printf("Not support zmodem yet. using xmodem\n");
-            printf("Ready for downling using xmodem\n");
-            printf("Wating...\n");
-//            return xmodem_receive(buf, size);
+            printf("Not support zmodem\n");
             break;
         default:
             printf("Not support this modem\n");
@@ -66,6 +64,261 @@ static u32 download_file(char *buf, size_t size, int modem)
     return 0;
 }
 
+/*
+ * Download straight to flash
+ *
+ * The image is staged in RAM as it arrives and each packet is
+ * acknowledged as soon as it is copied, so the sender never waits for
+ * the flash.  If the chip can start an erase or a program without
+ * waiting for it, the flash is driven from the receiver's idle hook:
+ * an erase block is erased when its first data arrives, and the data
+ * of the erased blocks is programmed, one write buffer at a time, while
+ * the next packets come in.  Erasing and programming only overlap the
+ * transfer, a single NOR chip can not erase one block and program
+ * another at the same time.
+ *
+ * Otherwise each erase block is erased and programmed as soon as it is
+ * complete, before the packet that completed it is acknowledged.
+ *
+ * Nothing may be printed until the transfer is over.
+ */
+#define FS_IDLE             0
+#define FS_ERASE            1
+#define FS_WRITE            2
+
+#define FS_WRITE_CHUNK      256         /* largest CFI write buffer */
+#define FS_BUSY_MS          10000       /* longer than any block erase */
+
+typedef struct {
+    struct mtd_info *mtd;
+    u32 to;             /* flash offset of the image */
+    u_char *buf;        /* staging buffer */
+    u32 staged;         /* bytes received */
+    u32 erased;         /* bytes erased */
+    u32 done;           /* bytes programmed */
+    int op;             /* FS_ERASE or FS_WRITE running, or FS_IDLE */
+    u32 op_ofs;         /* ... from this image offset */
+    u32 op_len;
+    u32 op_t0;
+    u32 tb_khz;
+    int error;
+} flash_stage_t;
+
+/* erase the next erase block and program len bytes of it */
+static int flash_stage_block(flash_stage_t *st, u32 blk_size, u32 len)
+{
+    struct mtd_info *mtd = st->mtd;
+    struct erase_info erase;
+    size_t retlen;
+
+    memset(&erase, 0, sizeof(erase));
+    erase.mtd = mtd;
+    erase.addr = st->to + st->done;
+    erase.len = blk_size;
+    if (mtd->erase(mtd, &erase))
+        return -1;
+    if (mtd->write(mtd, st->to + st->done, len, &retlen, st->buf + st->done) ||
+        retlen != len)
+        return -1;
+    st->done += len;
+    return 0;
+}
+
+static int flash_stage_sink(void *arg, u32 ofs, const u8 *data, u32 len)
+{
+    flash_stage_t *st = arg;
+    u32 blk_size;
+
+    memcpy(st->buf + ofs, data, len);
+    st->staged = ofs + len;
+
+    for (;;) {
+        blk_size = find_erase_size(st->mtd, st->to + st->done, 1);
+        if (blk_size == 0 || st->staged - st->done < blk_size)
+            return 0;
+        if (flash_stage_block(st, blk_size, blk_size) < 0)
+            return -1;
+    }
+}
+
+/* 1 while an erase or program runs, 0 when it is over, -1 if it failed */
+static int flash_stage_busy(flash_stage_t *st)
+{
+    int ret;
+
+    if (st->op == FS_IDLE)
+        return 0;
+    ret = st->mtd->busy(st->mtd, st->to + st->op_ofs);
+    if (ret > 0) {
+        if (sysTimeBaseLGet() - st->op_t0 < FS_BUSY_MS * st->tb_khz)
+            return 1;
+        ret = -1;
+    }
+    if (ret < 0)
+        st->error = 1;
+    else if (st->op == FS_ERASE)
+        st->erased = st->op_ofs + st->op_len;
+    else
+        st->done = st->op_ofs + st->op_len;
+    st->op = FS_IDLE;
+    return ret;
+}
+
+/*
+ * Move the flash on by at most one step, without waiting for it
+ *
+ * Erased data is programmed first, in whole write buffers until the
+ * transfer is over (final).  Returns 0, or -1 once anything failed.
+ */
+static int flash_stage_poll(flash_stage_t *st, int final)
+{
+    struct mtd_info *mtd = st->mtd;
+    size_t retlen;
+    u32 n;
+
+    if (st->error || flash_stage_busy(st) < 0)
+        return -1;
+    if (st->op != FS_IDLE)
+        return 0;
+
+    n = ((st->staged < st->erased) ? st->staged : st->erased) - st->done;
+    if (n >= FS_WRITE_CHUNK || (final && n > 0)) {
+        if (mtd->write_start(mtd, st->to + st->done, n, &retlen,
+                st->buf + st->done) || retlen == 0 || retlen > n) {
+            st->error = 1;
+            return -1;
+        }
+        st->op = FS_WRITE;
+        st->op_ofs = st->done;
+        st->op_len = retlen;
+    } else if (st->erased < st->staged) {
+        n = find_erase_size(mtd, st->to + st->erased, 1);
+        if (n == 0 || mtd->erase_start(mtd, st->to + st->erased)) {
+            st->error = 1;
+            return -1;
+        }
+        st->op = FS_ERASE;
+        st->op_ofs = st->erased;
+        st->op_len = n;
+    } else {
+        return 0;
+    }
+    st->op_t0 = sysTimeBaseLGet();
+    return 0;
+}
+
+static int flash_pipe_sink(void *arg, u32 ofs, const u8 *data, u32 len)
+{
+    flash_stage_t *st = arg;
+
+    memcpy(st->buf + ofs, data, len);
+    st->staged = ofs + len;
+    return flash_stage_poll(st, 0);
+}
+
+static void flash_pipe_idle(void *arg)
+{
+    (void)flash_stage_poll(arg, 0);
+}
+
+/* program what is left once the transfer is over */
+static int flash_pipe_flush(flash_stage_t *st)
+{
+    while (st->done < st->staged || st->op != FS_IDLE)
+        if (flash_stage_poll(st, 1) < 0)
+            return -1;
+    return 0;
+}
+
+/* returns the length written, or 0 */
+static u32 download_to_flash(u32 to, size_t size, char *buf, int flag)
+{
+    flash_stage_t st;
+    struct erase_info erase;
+    u_char vbuf[256];
+    size_t retlen;
+    u32 blk_size, ofs, n;
+    long len;
+    int pipe;
+
+    blk_size = find_erase_size(mymtd, to, 1);
+    if (blk_size == 0 || (to % blk_size) != 0) {
+        /* not on an erase block: download all, then write it */
+        len = download_file(buf, size, X_MODEM);
+        if (len == 0 || write_to_flash(to, len, (u_char *)buf, flag))
+            return 0;
+        return len;
+    }
+
+    if ((flag & MF_LOCKED) &&
+        mymtd->unlock(mymtd, to, find_erase_size(mymtd, to, size))) {
+        printf("Can't unlock the flash\n");
+        return 0;
+    }
+
+    memset(&st, 0, sizeof(st));
+    st.mtd = mymtd;
+    st.to = to;
+    st.buf = (u_char *)buf;
+    st.tb_khz = sysTimeBaseFreqGet() / 1000;
+    pipe = (mymtd->erase_start != NULL && mymtd->write_start != NULL &&
+        mymtd->busy != NULL);
+
+    printf("Ready for downloading to flash 0x%08lx using xmodem or ymodem...\n", to);
+    printf("Waiting...\n");
+    if (pipe)
+        len = xmodem_receive_to(flash_pipe_sink, flash_pipe_idle, &st, size);
+    else
+        len = xmodem_receive_to(flash_stage_sink, NULL, &st, size);
+
+    /* hacked by nandy. delay for serial output */
+    { int i = 0x10000; while (i > 0) i--; }
+
+    if (len < 0) {
+        while (pipe && flash_stage_busy(&st) > 0)
+            ;
+        printf("Failed downloading file, 0x%08lx bytes programmed\n", st.done);
+        return 0;
+    }
+    if (pipe) {
+        if (flash_pipe_flush(&st) < 0) {
+            printf("Failed writing flash at 0x%08lx\n", to + st.done);
+            return 0;
+        }
+    } else if (st.done < len &&
+        flash_stage_block(&st, find_erase_size(mymtd, to + st.done, 1),
+            len - st.done) < 0) {
+        printf("Failed writing flash at 0x%08lx\n", to + st.done);
+        return 0;
+    }
+
+    /* a JFFS2 partition must not keep old nodes after the image */
+    blk_size = find_erase_size(mymtd, to, len);
+    if ((flag & MF_JFFS2) && blk_size < size) {
+        memset(&erase, 0, sizeof(erase));
+        erase.mtd = mymtd;
+        erase.addr = to + blk_size;
+        erase.len = size - blk_size;
+        if (mymtd->erase(mymtd, &erase))
+            printf("Erasing the rest of the partition failed\n");
+    }
+
+    printf("Verifying... ");
+    for (ofs = 0; ofs < len; ofs += n) {
+        n = (len - ofs < sizeof(vbuf)) ? len - ofs : sizeof(vbuf);
+        if (mymtd->read(mymtd, to + ofs, n, &retlen, vbuf) || retlen != n ||
+            memcmp(vbuf, buf + ofs, n) != 0) {
+            printf(" ... failed near offset 0x%08lx\n", ofs);
+            return 0;
+        }
+    }
+    printf(" ... done\n");
+
+    if ((flag & MF_LOCKED) && mymtd->lock(mymtd, to, blk_size))
+        printf("Can't lock the flash\n");
+    return len;
+}
+
 /*
  * Sub-commands
  */
@@ -78,7 +331,7 @@ user_subcommand_t load_cmds[];
  */
 static void command_load_ram(int argc, const char **argv)
 {
-    int ret;
+    char *endp;
     char *buf = (char *)RAM_BASE;
     size_t size;
     u32 retlen;
@@ -92,25 +345,26 @@ static void command_load_ram(int argc, const char **argv)
         goto error_parse_arg;
       break;
     case 3:
-      buf = (char *)strtoul(argv[1], NULL, 0);
-      if (ret)
+      buf = (char *)strtoul(argv[1], &endp, 0);
+      if (*endp != '\0')
         goto error_parse_arg;
       size = 0;
       if ((modem = modem_is(argv[2])) == UNKNOWN_MODEM)
         goto error_parse_arg;
       break;
     case 4:
-      buf = (char *)strtoul(argv[1], NULL, 0);
-      if (ret)
+      buf = (char *)strtoul(argv[1], &endp, 0);
+      if (*endp != '\0')
         goto error_parse_arg;
-      size = (size_t)strtoul(argv[2], NULL, 0);
-      if (ret)
+      size = (size_t)strtoul(argv[2], &endp, 0);
+      if (*endp != '\0')
         goto error_parse_arg;
       if ((modem = modem_is(argv[3])) == UNKNOWN_MODEM)
         goto error_parse_arg;
       break;
     default:
       printf("invalid 'load ram' command: too few or many arguments\n");
+      cmd_status = -1;
       return;
     }
 
@@ -124,12 +378,13 @@ error_parse_arg:
     printf("Can't parsing argumets\n");
 error_download:
     printf("Failed downloading file\n");
+    cmd_status = -1;
     return;
 }
 
 static void command_load_flash(int argc, const char **argv)
 {
-    int ret;
+    char *endp;
     u32 to; 
     char *buf = (char *)RAM_BASE;
     size_t size;
@@ -140,12 +395,15 @@ static void command_load_flash(int argc, const char **argv)
 
     if (argc != 4 && argc != 3) {
         printf("invalid 'load flash' command: too few or many arguments\n");
+        cmd_status = -1;
+        return;
     }
 
     if (argc == 3) {
         dst_part = get_mtd_partition(argv[1]);
         if (dst_part == NULL) {
             //printf("Could not found \"%s\" partition\n", argv[1]);
+            cmd_status = -1;
             return;
         }
         to = dst_part->offset;
@@ -154,37 +412,36 @@ static void command_load_flash(int argc, const char **argv)
         modem = modem_is(argv[2]);
 
     } else {
-        to = strtoul(argv[1], NULL, 0);
-        if (ret) goto error_parse_arg;
-        size = (size_t)strtoul(argv[2], NULL, 0);
-        if (ret) goto error_parse_arg;
+        to = strtoul(argv[1], &endp, 0);
+        if (*endp != '\0') goto error_parse_arg;
+        size = (size_t)strtoul(argv[2], &endp, 0);
+        if (*endp != '\0') goto error_parse_arg;
         modem = modem_is(argv[3]);
         flag = 0;
     }
 
-    retlen = download_file(buf, size, modem);
-
-    /* hacked by nandy. delay for serial output */
-    { int i = 0x10000; while (i > 0) i--; }
-
-    if (retlen == 0) {
-        printf("Failed downloading file\n");
+    if (modem != X_MODEM && modem != Y_MODEM) {
+        printf("Not support this modem\n");
+        cmd_status = -1;
         return;
     }
-    printf("Downloaded file at 0x%08lx, size = %d bytes\n", buf, retlen);
-
-    if (retlen > size) {
-        printf("An image size is too large to write flash.\n\t\t\t"
-            "wanted = 0x%08lx, loaded = 0x%08lx\n", size, retlen);
+    if (mymtd == NULL) {
+        printf("Error. invalid MTD informations\n");
+        cmd_status = -1;
         return;
     }
 
-    ret = write_to_flash(to, retlen, buf, flag);
-
+    retlen = download_to_flash(to, size, buf, flag);
+    if (retlen == 0) {
+        cmd_status = -1;
+        return;
+    }
+    printf("Written %d bytes to flash at 0x%08lx\n", retlen, to);
     return;
 
 error_parse_arg:
     printf("Can't parsing argumets\n");
+    cmd_status = -1;
     return;
 }
 
@@ -225,7 +482,7 @@ void command_load(int argc, const char **argv)
     execsubcmd(load_cmds, argc-1, argv+1);
 }
 
-user_command_t load_cmd = {
+USER_CMD(load_cmd) = {
     "load",
     command_load,
     NULL,
@@ -0,0 +1,290 @@
+/*
+ * membench.c: Memory bandwidth and latency benchmark
+ *
+ * Measures, with the Time Base, what the memory system delivers with
+ * the current TLB and cache setup:
+ *
+ *   read    32-bit loads summed in registers
+ *   write   32-bit stores
+ *   fill    memset()
+ *   copy    memcpy(), from the first to the second half of the window
+ *   latency dependent loads along a random cyclic chain of cache lines
+ *
+ * Each test is swept over block sizes that fit in L1, in L2 and only
+ * in DDR, and repeated until MB_PASS_BYTES are moved.  A second table
+ * gives the copy rate for misaligned source and destination.
+ *
+ * The window defaults to a heap buffer in DDR.  Another RAM window
+ * (e.g. L2 SRAM) can be given; a read-only window (e.g. the NOR flash)
+ * only gets the read test.
+ */
+
+#include "command.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wrboot.h>
+#include <types.h>
+
+#define MB_LINE             32              /* e500 cache line */
+#define MB_DDR_SPAN         SZ_32M          /* default window */
+#define MB_PASS_BYTES       SZ_8M           /* data moved per measurement */
+#define MB_MIN_SIZE         SZ_4K
+#define MB_MAX_SIZE         SZ_16M
+#define MB_LAT_STEPS        65536           /* loads per latency run */
+
+enum { MB_READ, MB_WRITE, MB_FILL, MB_COPY };
+
+static u32 tb_khz;
+static u8 *mb_ddr_buf;          /* default window, allocated once */
+
+static const struct {
+    u32 src_ofs;
+    u32 dst_ofs;
+} mb_align[] = {
+    { 0, 0 }, { 1, 0 }, { 0, 1 }, { 3, 1 }, { 4, 0 }, { 0, 4 }, { 8, 0 }
+};
+
+/*
+ * Kernels
+ */
+FAST_FUNC static u32 mb_read(const u32 *p, u32 bytes)
+{
+    const u32 *end = p + bytes / sizeof(u32);
+    u32 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    for (; p + 8 <= end; p += 8) {
+        s0 += p[0] + p[4];
+        s1 += p[1] + p[5];
+        s2 += p[2] + p[6];
+        s3 += p[3] + p[7];
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+FAST_FUNC static void mb_write(volatile u32 *p, u32 bytes, u32 val)
+{
+    volatile u32 *end = p + bytes / sizeof(u32);
+
+    for (; p + 8 <= end; p += 8) {
+        p[0] = val; p[1] = val; p[2] = val; p[3] = val;
+        p[4] = val; p[5] = val; p[6] = val; p[7] = val;
+    }
+}
+
+FAST_FUNC static void *mb_chase(void **p, u32 steps)
+{
+    while (steps--)
+        p = (void **)*p;
+    return p;
+}
+
+/*
+ * Rates from Time Base ticks, in 32-bit arithmetic (no libgcc)
+ */
+
+/* MiB/s, bytes <= 16M */
+static u32 mb_rate(u32 bytes, u32 ticks)
+{
+    if (ticks == 0)
+        ticks = 1;
+    return ((bytes >> 10) * tb_khz / ticks) * 125 / 128;
+}
+
+/* 1/10 ns per access, steps <= 64K */
+static u32 mb_tenth_ns(u32 ticks, u32 steps)
+{
+    u32 p10 = 100000000 / tb_khz;   /* Time Base period in 10ps */
+
+    return ((ticks / steps) * p10 + (ticks % steps) * p10 / steps) / 10;
+}
+
+/* one bandwidth measurement, returns MiB/s */
+static u32 mb_measure(int test, u8 *dst, u8 *src, u32 size)
+{
+    u32 reps, i, t0 = 0, ticks;
+    volatile u32 sink = 0;
+
+    reps = (size < MB_PASS_BYTES) ? MB_PASS_BYTES / size : 1;
+
+    for (i = 0; i <= reps; i++) {
+        if (i == 1)     /* the first pass warms up caches and TLB */
+            t0 = sysTimeBaseLGet();
+        switch (test) {
+        case MB_READ:
+            sink += mb_read((const u32 *)src, size);
+            break;
+        case MB_WRITE:
+            mb_write((volatile u32 *)dst, size, i);
+            break;
+        case MB_FILL:
+            memset(dst, i, size);
+            break;
+        case MB_COPY:
+            memcpy(dst, src, size);
+            break;
+        }
+    }
+    ticks = sysTimeBaseLGet() - t0;
+
+    return mb_rate(reps * size, ticks);
+}
+
+/* load to use latency over a block, returns 1/10 ns */
+static u32 mb_latency(u8 *buf, u32 size)
+{
+    u32 n = size / MB_LINE;
+    u32 i, j, tmp, seed = 0x2545f491;
+    u32 t0, ticks;
+    void **p;
+
+    /* Sattolo's shuffle of the lines: one cycle through all of them */
+    for (i = 0; i < n; i++)
+        *(u32 *)(buf + i * MB_LINE) = i;
+    for (i = n - 1; i > 0; i--) {
+        seed = seed * 1664525 + 1013904223;
+        j = (seed >> 8) % i;
+        tmp = *(u32 *)(buf + i * MB_LINE);
+        *(u32 *)(buf + i * MB_LINE) = *(u32 *)(buf + j * MB_LINE);
+        *(u32 *)(buf + j * MB_LINE) = tmp;
+    }
+    for (i = 0; i < n; i++) {
+        p = (void **)(buf + i * MB_LINE);
+        *p = buf + *(u32 *)p * MB_LINE;
+    }
+
+    p = mb_chase((void **)buf, n);      /* warm up */
+    t0 = sysTimeBaseLGet();
+    p = mb_chase(p, MB_LAT_STEPS);
+    ticks = sysTimeBaseLGet() - t0;
+    if (p == NULL)
+        printf("?");
+
+    return mb_tenth_ns(ticks, MB_LAT_STEPS);
+}
+
+static void mb_print_size(u32 size)
+{
+    if (size >= SZ_1M)
+        printf("%6dM", size >> 20);
+    else
+        printf("%6dK", size >> 10);
+}
+
+/*
+ * Sweep a window: copies go from its first to its second half
+ */
+static void mb_sweep(u8 *base, u32 span, int ro)
+{
+    u8 *half = base + span / 2;
+    u32 size, lat, i;
+
+    printf(ro ? "   size  read MB/s\n" :
+        "   size  read MB/s write MB/s  fill MB/s  copy MB/s latency ns\n");
+    for (size = MB_MIN_SIZE; size <= MB_MAX_SIZE && size <= span; size <<= 2) {
+        mb_print_size(size);
+        printf(" %10d", mb_measure(MB_READ, NULL, base, size));
+        if (ro) {
+            printf("\n");
+            continue;
+        }
+        printf(" %10d", mb_measure(MB_WRITE, base, NULL, size));
+        printf(" %10d", mb_measure(MB_FILL, base, NULL, size));
+        if (size <= span / 2)
+            printf(" %10d", mb_measure(MB_COPY, half, base, size));
+        else
+            printf("          -");
+        lat = mb_latency(base, size);
+        printf(" %7d.%d\n", lat / 10, lat % 10);
+    }
+    if (ro)
+        return;
+
+    size = (span / 2 < SZ_1M) ? span / 2 - MB_LINE : SZ_1M;
+    printf("\nmemcpy of ");
+    mb_print_size(size);
+    printf(", src/dst offset and MB/s\n");
+    for (i = 0; i < ARRAY_SIZE(mb_align); i++)
+        printf("  %d/%d", mb_align[i].src_ofs, mb_align[i].dst_ofs);
+    printf("\n");
+    for (i = 0; i < ARRAY_SIZE(mb_align); i++)
+        printf(" %4d", mb_measure(MB_COPY, half + mb_align[i].dst_ofs,
+            base + mb_align[i].src_ofs, size));
+    printf("\n");
+}
+
+/*
+ * vivi> membench
+ * vivi> membench <addr> <span>
+ * vivi> membench ro <addr> <span>
+ * vivi> membench copy <src> <dst> <size>
+ */
+static void command_membench(int argc, const char **argv)
+{
+    u8 *base, *dst;
+    u32 span, size;
+    int ro = 0;
+
+    tb_khz = sysTimeBaseFreqGet() / 1000;
+    if (tb_khz == 0) {
+        printf("membench: Time Base is not running\n");
+        cmd_status = -1;
+        return;
+    }
+
+    if (argc == 5 && strcmp(argv[1], "copy") == 0) {
+        base = (u8 *)strtoul(argv[2], NULL, 0);
+        dst = (u8 *)strtoul(argv[3], NULL, 0);
+        size = strtoul(argv[4], NULL, 0) & ~(MB_LINE - 1);
+        if (size == 0 || size > MB_MAX_SIZE) {
+            printf("membench: size must be 32 bytes to 16M\n");
+            cmd_status = -1;
+            return;
+        }
+        printf("memcpy 0x%08lx -> 0x%08lx: %d MB/s, read %d MB/s\n",
+            base, dst, mb_measure(MB_COPY, dst, base, size),
+            mb_measure(MB_READ, NULL, base, size));
+        return;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "ro") == 0) {
+        ro = 1;
+        argc--;
+        argv++;
+    }
+    if (argc == 3) {
+        base = (u8 *)strtoul(argv[1], NULL, 0);
+        span = strtoul(argv[2], NULL, 0) & ~(MB_LINE - 1);
+    } else if (argc == 1 && !ro) {
+        if (mb_ddr_buf == NULL)
+            mb_ddr_buf = kmalloc(MB_DDR_SPAN + MB_LINE);
+        if (mb_ddr_buf == NULL) {
+            printf("membench: can not allocate the DDR window\n");
+            cmd_status = -1;
+            return;
+        }
+        base = (u8 *)(((u32)mb_ddr_buf + MB_LINE - 1) & ~(MB_LINE - 1));
+        span = MB_DDR_SPAN;
+    } else {
+        printf("invalid 'membench' command: wrong arguments\n");
+        printf("Usage: membench [[ro] <addr> <span>] | [copy <src> <dst> <size>]\n");
+        cmd_status = -1;
+        return;
+    }
+    if (span < MB_MIN_SIZE) {
+        printf("membench: window must be at least 4K\n");
+        cmd_status = -1;
+        return;
+    }
+
+    printf("membench: 0x%08lx-0x%08lx%s, Time Base %d kHz\n",
+        base, base + span - 1, ro ? " read-only" : "", tb_khz);
+    mb_sweep(base, span, ro);
+}
+
+USER_CMD(membench_cmd) = {
+    "membench",
+    command_membench,
+    NULL,
+    "membench [[ro] <addr> <span>] \t-- Memory bandwidth and latency"
+};
@@ -0,0 +1,448 @@
+/*
+ * msearch.c: Search memory or flash for strings and values
+ *
+ *   one string      Boyer-Moore-Horspool; patterns shorter than 4 bytes
+ *                   scan a word at a time for the first byte instead
+ *   several strings Aho-Corasick, one pass through a DFA
+ *   32-bit value    aligned words, (word & mask) == value
+ *   64-bit value    aligned double words, likewise
+ *
+ * A string argument is taken as text unless it starts with "0x", in
+ * which case it gives the bytes in hex: "0x27051956" finds a uImage
+ * header.  Values are big endian, as the CPU sees them.
+ *
+ * The range is searched in MS_CHUNK pieces, between which a key hit
+ * stops the search.  Only the first hits are printed, all are counted.
+ */
+
+#include "command.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wrboot.h>
+#include <types.h>
+
+#define MS_CHUNK            SZ_1M
+#define MS_MAX_PRINT        32              /* default hits shown */
+#define MS_MAX_PATTERNS     8
+#define MS_MAX_PLEN         64
+#define MS_MAX_STATES       (MS_MAX_PATTERNS * MS_MAX_PLEN + 1)
+
+#define MS_ONES             0x01010101
+#define MS_HIGHS            0x80808080
+#define MS_HASZERO(v)       (((v) - MS_ONES) & ~(v) & MS_HIGHS)
+
+typedef struct {
+    u8  data[MS_MAX_PLEN];
+    u32 len;
+} ms_pattern_t;
+
+static ms_pattern_t ms_pat[MS_MAX_PATTERNS];
+static int ms_npat;
+static u32 ms_hits;
+static u32 ms_max_print;
+static u16 *ms_delta;                   /* Aho-Corasick DFA, allocated once */
+
+/*
+ * Helpers
+ */
+static int ms_hexval(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* "text" or "0x<hex bytes>", returns -1 if it is not valid */
+static int ms_parse_pattern(const char *s, ms_pattern_t *pat)
+{
+    int hi, lo;
+    u32 n = 0;
+
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        s += 2;
+        if (strlen(s) & 1)
+            return -1;
+        for (; *s != '\0'; s += 2) {
+            hi = ms_hexval(s[0]);
+            lo = ms_hexval(s[1]);
+            if (hi < 0 || lo < 0 || n >= MS_MAX_PLEN)
+                return -1;
+            pat->data[n++] = (hi << 4) | lo;
+        }
+    } else {
+        for (; *s != '\0'; s++) {
+            if (n >= MS_MAX_PLEN)
+                return -1;
+            pat->data[n++] = *s;
+        }
+    }
+    pat->len = n;
+    return (n > 0) ? 0 : -1;
+}
+
+/* up to 16 hex digits, with or without "0x" */
+static int ms_parse_u64(const char *s, u32 *hi, u32 *lo)
+{
+    int d, n = 0;
+
+    *hi = *lo = 0;
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+        s += 2;
+    for (; *s != '\0'; s++, n++) {
+        d = ms_hexval(*s);
+        if (d < 0 || n >= 16)
+            return -1;
+        *hi = (*hi << 4) | (*lo >> 28);
+        *lo = (*lo << 4) | d;
+    }
+    return (n > 0) ? 0 : -1;
+}
+
+static int ms_poll_abort(void)
+{
+    if (tstc()) {
+        (void)getc();
+        return 1;
+    }
+    return 0;
+}
+
+static void ms_hit(const u8 *addr, int pattern)
+{
+    if (ms_hits++ < ms_max_print) {
+        if (pattern < 0)
+            printf("  0x%08lx\n", addr);
+        else
+            printf("  0x%08lx: pattern %d\n", addr, pattern + 1);
+    } else if (ms_hits == ms_max_print + 1) {
+        printf("  ...\n");
+    }
+}
+
+/*
+ * Kernels: each returns the next hit at or after p, or NULL.  They
+ * count the bytes left to end, which wraps to 0 for a range ending at
+ * the top of the address space (the NOR flash).
+ */
+
+/* first occurrence of a 1 to 3 byte pattern, a word at a time */
+FAST_FUNC static const u8 *ms_find_short(const u8 *p, const u8 *end,
+                     const u8 *pat, u32 plen)
+{
+    u32 n = (u32)end - (u32)p;
+    u32 rep = pat[0] * MS_ONES;
+    u32 v, i;
+
+    /* bytes up to the first aligned word */
+    for (; n >= plen && ((u32)p & 3) != 0; p++, n--)
+        if (p[0] == pat[0] && memcmp(p, pat, plen) == 0)
+            return p;
+
+    /* whole words, checked for the first byte of the pattern */
+    for (; n >= 4; p += 4, n -= 4) {
+        v = *(const u32 *)p ^ rep;
+        if (MS_HASZERO(v) == 0)
+            continue;
+        for (i = 0; i < 4; i++)
+            if (i + plen <= n && p[i] == pat[0] && memcmp(p + i, pat, plen) == 0)
+                return p + i;
+    }
+
+    for (; n >= plen; p++, n--)
+        if (p[0] == pat[0] && memcmp(p, pat, plen) == 0)
+            return p;
+    return NULL;
+}
+
+FAST_FUNC static const u8 *ms_find_bmh(const u8 *p, const u8 *end,
+                       const u8 *pat, u32 plen, const u8 *skip)
+{
+    u32 n = (u32)end - (u32)p;
+    u8 tail = pat[plen - 1];
+    u8 c;
+
+    /* a shift is at most plen, so it never passes end */
+    while (n >= plen) {
+        c = p[plen - 1];
+        if (c == tail && memcmp(p, pat, plen - 1) == 0)
+            return p;
+        p += skip[c];
+        n -= skip[c];
+    }
+    return NULL;
+}
+
+FAST_FUNC static const u32 *ms_find_u32(const u32 *p, const u32 *end,
+                        u32 value, u32 mask)
+{
+    u32 n = ((u32)end - (u32)p) / 4;
+
+    for (; n >= 4; p += 4, n -= 4) {
+        if ((p[0] & mask) == value) return p;
+        if ((p[1] & mask) == value) return p + 1;
+        if ((p[2] & mask) == value) return p + 2;
+        if ((p[3] & mask) == value) return p + 3;
+    }
+    for (; n > 0; p++, n--)
+        if ((*p & mask) == value)
+            return p;
+    return NULL;
+}
+
+FAST_FUNC static const u32 *ms_find_u64(const u32 *p, const u32 *end,
+                        const u32 *value, const u32 *mask)
+{
+    u32 vh = value[0], vl = value[1], mh = mask[0], ml = mask[1];
+    u32 n = ((u32)end - (u32)p) / 8;
+
+    for (; n > 0; p += 2, n--)
+        if ((p[1] & ml) == vl && (p[0] & mh) == vh)
+            return p;
+    return NULL;
+}
+
+/* runs the DFA from *state, stops after the last byte of a match */
+FAST_FUNC static const u8 *ms_find_ac(const u8 *p, const u8 *end,
+                      const u16 *delta, const u8 *out, u32 *state)
+{
+    u32 s = *state;
+    u32 n = (u32)end - (u32)p;
+
+    while (n-- > 0) {
+        s = delta[(s << 8) | *p++];
+        if (out[s] != 0)
+            break;
+    }
+    *state = s;
+    return p;
+}
+
+/*
+ * Searches
+ */
+static void ms_search_string(const u8 *base, u32 len)
+{
+    const u8 *pat = ms_pat[0].data;
+    u32 plen = ms_pat[0].len;
+    u8 skip[256];
+    const u8 *p, *end;
+    u32 ofs, n, i;
+
+    /* shifts are capped at 255, MS_MAX_PLEN keeps them exact */
+    for (i = 0; i < 256; i++)
+        skip[i] = plen;
+    for (i = 0; i < plen - 1; i++)
+        skip[pat[i]] = plen - 1 - i;
+
+    for (ofs = 0; ofs < len; ofs += n) {
+        if (ms_poll_abort())
+            break;
+        /* a hit starts in this chunk, it may end in the next one */
+        n = (len - ofs < MS_CHUNK) ? len - ofs : MS_CHUNK;
+        end = (len - ofs - n < plen) ? base + len : base + ofs + n + plen - 1;
+        for (p = base + ofs; ; p++) {
+            if (plen < 4)
+                p = ms_find_short(p, end, pat, plen);
+            else
+                p = ms_find_bmh(p, end, pat, plen, skip);
+            if (p == NULL || (u32)p - (u32)base >= ofs + n)
+                break;
+            ms_hit(p, -1);
+        }
+    }
+}
+
+static int ms_search_multi(const u8 *base, u32 len)
+{
+    u16 *delta = ms_delta;
+    u8 out[MS_MAX_STATES];
+    u16 fail[MS_MAX_STATES], queue[MS_MAX_STATES];
+    u32 nstates = 1, head = 0, tail = 0;
+    u32 s, t, c, ofs, n, state = 0;
+    const u8 *p, *chunk_end;
+    int i, j;
+
+    if (delta == NULL)
+        delta = ms_delta = kmalloc(MS_MAX_STATES * 256 * sizeof(u16));
+    if (delta == NULL) {
+        printf("msearch: out of memory\n");
+        return -1;
+    }
+    memset(delta, 0, MS_MAX_STATES * 256 * sizeof(u16));
+    memset(out, 0, sizeof(out));
+
+    /* trie of the patterns, state 0 is the root */
+    for (i = 0; i < ms_npat; i++) {
+        s = 0;
+        for (j = 0; j < ms_pat[i].len; j++) {
+            t = delta[(s << 8) | ms_pat[i].data[j]];
+            if (t == 0) {
+                t = nstates++;
+                delta[(s << 8) | ms_pat[i].data[j]] = t;
+            }
+            s = t;
+        }
+        out[s] |= 1 << i;
+    }
+
+    /*
+     * Breadth first, a state's failure state is done before it, so the
+     * missing transitions are copied from there.
+     */
+    queue[tail++] = 0;
+    fail[0] = 0;
+    while (head < tail) {
+        s = queue[head++];
+        for (c = 0; c < 256; c++) {
+            t = delta[(s << 8) | c];
+            if (t != 0) {
+                fail[t] = (s == 0) ? 0 : delta[(fail[s] << 8) | c];
+                out[t] |= out[fail[t]];
+                queue[tail++] = t;
+            } else if (s != 0) {
+                delta[(s << 8) | c] = delta[(fail[s] << 8) | c];
+            }
+        }
+    }
+
+    for (ofs = 0; ofs < len; ofs += n) {
+        if (ms_poll_abort())
+            break;
+        n = (len - ofs < MS_CHUNK) ? len - ofs : MS_CHUNK;
+        chunk_end = base + ofs + n;
+        for (p = base + ofs; p != chunk_end; ) {
+            p = ms_find_ac(p, chunk_end, delta, out, &state);
+            if (out[state] == 0)
+                break;
+            for (i = 0; i < ms_npat; i++)
+                if (out[state] & (1 << i))
+                    ms_hit(p - ms_pat[i].len, i);
+        }
+    }
+
+    return 0;
+}
+
+static void ms_search_value(const u8 *base, u32 len, int dwords,
+                const u32 *value, const u32 *mask)
+{
+    const u32 *p, *chunk_end;
+    u32 ofs, n, step = dwords ? 8 : 4;
+
+    len &= ~(step - 1);
+    for (ofs = 0; ofs < len; ofs += n) {
+        if (ms_poll_abort())
+            break;
+        n = (len - ofs < MS_CHUNK) ? len - ofs : MS_CHUNK;
+        chunk_end = (const u32 *)(base + ofs + n);
+        for (p = (const u32 *)(base + ofs); ; p += step / 4) {
+            if (dwords)
+                p = ms_find_u64(p, chunk_end, value, mask);
+            else
+                p = ms_find_u32(p, chunk_end, value[0], mask[0]);
+            if (p == NULL)
+                break;
+            ms_hit((const u8 *)p, -1);
+        }
+    }
+}
+
+/*
+ * vivi> msearch [-m <max hits shown>] <addr> <len> <string|0xbytes>...
+ * vivi> msearch [-m <max hits shown>] <addr> <len> -w <value> [<mask>]
+ * vivi> msearch [-m <max hits shown>] <addr> <len> -q <value> [<mask>]
+ */
+static void command_msearch(int argc, const char **argv)
+{
+    const u8 *base;
+    u32 len, value[2], mask[2];
+    int i;
+
+    ms_max_print = MS_MAX_PRINT;
+    if (argc > 2 && strcmp(argv[1], "-m") == 0) {
+        ms_max_print = strtoul(argv[2], NULL, 0);
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 4)
+        goto usage;
+
+    base = (const u8 *)strtoul(argv[1], NULL, 0);
+    len = strtoul(argv[2], NULL, 0);
+    if ((u32)base != 0 && len > 0 - (u32)base)
+        len = 0 - (u32)base;           /* up to the top of the address space */
+    ms_hits = 0;
+
+    if (strcmp(argv[3], "-w") == 0) {
+        if (argc != 5 && argc != 6)
+            goto usage;
+        value[0] = strtoul(argv[4], NULL, 0);
+        mask[0] = (argc == 6) ? strtoul(argv[5], NULL, 0) : 0xffffffff;
+        if (len < ((-(u32)base) & 3) + 4)
+            goto short_range;
+        len -= (-(u32)base) & 3;
+        base = (const u8 *)(((u32)base + 3) & ~3);
+        ms_search_value(base, len, 0, value, mask);
+    } else if (strcmp(argv[3], "-q") == 0) {
+        if (argc != 5 && argc != 6)
+            goto usage;
+        if (ms_parse_u64(argv[4], &value[0], &value[1]) < 0 ||
+            (argc == 6 && ms_parse_u64(argv[5], &mask[0], &mask[1]) < 0)) {
+            printf("msearch: bad 64-bit value\n");
+            cmd_status = -1;
+            return;
+        }
+        if (argc == 5)
+            mask[0] = mask[1] = 0xffffffff;
+        if (len < ((-(u32)base) & 7) + 8)
+            goto short_range;
+        len -= (-(u32)base) & 7;
+        base = (const u8 *)(((u32)base + 7) & ~7);
+        ms_search_value(base, len, 1, value, mask);
+    } else {
+        if (argc - 3 > MS_MAX_PATTERNS) {
+            printf("msearch: at most %d patterns\n", MS_MAX_PATTERNS);
+            cmd_status = -1;
+            return;
+        }
+        for (ms_npat = 0, i = 3; i < argc; i++, ms_npat++) {
+            if (ms_parse_pattern(argv[i], &ms_pat[ms_npat]) < 0) {
+                printf("msearch: bad pattern '%s'\n", argv[i]);
+                cmd_status = -1;
+                return;
+            }
+        }
+        if (ms_npat == 1) {
+            ms_search_string(base, len);
+        } else if (ms_search_multi(base, len) < 0) {
+            cmd_status = -1;
+            return;
+        }
+    }
+
+    printf("msearch: %d hit(s)\n", ms_hits);
+    return;
+
+short_range:
+    printf("msearch: no aligned value in the range\n");
+    cmd_status = -1;
+    return;
+
+usage:
+    printf("invalid 'msearch' command: wrong arguments\n");
+    printf("Usage: msearch [-m <max>] <addr> <len> <string|0xbytes>...\n");
+    printf("       msearch [-m <max>] <addr> <len> -w|-q <value> [<mask>]\n");
+    cmd_status = -1;
+}
+
+USER_CMD(msearch_cmd) = {
+    "msearch",
+    command_msearch,
+    NULL,
+    "msearch <addr> <len> <pattern>... \t-- Search memory"
+};
@@ -175,6 +175,16 @@ struct mtd_info {
     int (*lock) (struct mtd_info *mtd, loff_t ofs, size_t len);
     int (*unlock) (struct mtd_info *mtd, loff_t ofs, size_t len);
 
+    /* Start an erase or a program and return at once, busy() tells when
+     * it is over (1 busy, 0 done, < 0 failed).  Lets a download keep
+     * the flash working while it waits for data; NULL if the chip only
+     * has the blocking erase and write.  write_start() may start less
+     * than len, e.g. one write buffer.
+     */
+    int (*erase_start) (struct mtd_info *mtd, loff_t ofs);
+    int (*write_start) (struct mtd_info *mtd, loff_t to, size_t len, size_t *retlen, const u_char *buf);
+    int (*busy) (struct mtd_info *mtd, loff_t ofs);
+
     void *priv;
 };
 
@@ -182,6 +192,9 @@ struct mtd_info {
  * VIVI Interfaces
  */
 int write_to_flash(loff_t ofs, size_t len, const u_char *buf, int flag);
+int mtd_block(struct mtd_info *mtd, u_int32_t ofs, u_int32_t *start,
+              u_int32_t *size);
+size_t find_erase_size(struct mtd_info *mtd, loff_t ofs, size_t len);
 int mtd_dev_init(void);
 
 /*
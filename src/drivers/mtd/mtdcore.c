@@ -45,99 +45,269 @@
 #include "mtd.h"
 #include "cfi.h"
 #include "priv_data.h"
+#include "command.h"
 
 /* temporary debugging macros */
 
 #define NULL 0
-#define FLASH_UNCACHED_BASE 0x10000000 
 
 #define CONFIG_DEBUG
 #define CONFIG_MSG_PROGRESS
 
+#define NOR_CHUNK   4096    /* flash read per compare */
+#define NOR_GAP     32      /* equal bytes programmed to save a write call */
+
 typedef enum {
     WS_LOCKING,
     WS_UNLOCKING,
     WS_FM_JFFS2,
-    WS_ERASING,
     WS_WRITING,
     WS_VERIFYING,
     WS_ERROR,
     WS_DONE
 } ws_state_t;
 
-//struct user_command_t;
-
-typedef struct user_command {
-    const char *name;
-    void (*cmdfunc)(int argc, const char **);
-    struct user_command *next_cmd;
-    const char *helpstr;
-} user_command_t;
+/* how the old contents of the flash can take the new data */
+enum {
+    NOR_SAME,       /* nothing to do */
+    NOR_PROGRAM,    /* only 1 -> 0 bits, program without erasing */
+    NOR_ERASE
+};
 
-typedef struct user_subcommand {
-    const char *name;
-    void (*cmdfunc)(int argc, const char **);
-    const char *helpstr;
-}user_subcommand_t;
+typedef struct {
+    int skipped;
+    int erased;
+    int programmed;
+} nor_stat_t;
 
 struct mtd_info *mymtd = NULL;
 
+static u32 nor_chunk[NOR_CHUNK / sizeof(u32)];
+static u_char *nor_save;        /* a block erased for a partial write */
+static u32 nor_save_size;
+
+
+/*
+ * The erase block holding ofs: stores its start and size and returns
+ * its number counted from the start of the device, or -1 past the end
+ */
+int
+mtd_block(struct mtd_info *mtd, u_int32_t ofs, u_int32_t *start,
+          u_int32_t *size)
+{
+    struct mtd_erase_region_info *r;
+    int i, blk = 0;
 
+    if (mtd->numeraseregions == 0) {
+        if (mtd->erasesize == 0 || ofs >= mtd->size)
+            return -1;
+        *size = mtd->erasesize;
+        *start = ofs - ofs % mtd->erasesize;
+        return ofs / mtd->erasesize;
+    }
+    for (i = 0; i < mtd->numeraseregions; i++) {
+        r = &mtd->eraseregions[i];
+        if (ofs >= r->offset && ofs - r->offset < r->erasesize * r->numblocks) {
+            *size = r->erasesize;
+            *start = ofs - (ofs - r->offset) % r->erasesize;
+            return blk + (ofs - r->offset) / r->erasesize;
+        }
+        blk += r->numblocks;
+    }
+    return -1;
+}
+
+/*
+ * Size of the erase blocks from the one holding ofs which take len bytes
+ */
 size_t 
 find_erase_size(struct mtd_info *mtd, loff_t ofs, size_t len)
 {
-        struct mtd_erase_region_info *regions = mtd->eraseregions;
-        size_t erasesize, retlen; 
-        int i, j, first, last;
+    u32 pos, start, size;
+    size_t retlen = 0;
 
-    switch (mtd->type) {
-    case MTD_NORFLASH:
-        i = 0;
-        while ((i < mtd->numeraseregions) && (ofs >= regions[i].offset)) {
-            i++;
+    if (mtd->type != MTD_NORFLASH) {
+        printf("Something wrong\n");
+        return 0;
+    }
+    for (pos = ofs; ; pos = start + size) {
+        if (mtd_block(mtd, pos, &start, &size) < 0)
+            return 0;
+        retlen += size;
+        if (len <= size)
+            return retlen;
+        len -= size;
+    }
+}
+
+/*
+ * Compare kernels.  The flash is mapped cache-inhibited, so it is read
+ * in chunks into a cached buffer and compared there a word at a time.
+ */
+FAST_FUNC static int
+nor_compare(const u32 *old, const u_char *new, u32 len)
+{
+    const u32 *nw = (const u32 *)new;
+    int ret = NOR_SAME;
+    u32 i = 0, o, n;
+
+    if (((u32)new & 3) == 0) {
+        for (; i + 4 <= len / 4; i += 4) {
+            if (((old[i] ^ nw[i]) | (old[i + 1] ^ nw[i + 1]) |
+                 (old[i + 2] ^ nw[i + 2]) | (old[i + 3] ^ nw[i + 3])) == 0)
+                continue;
+            for (o = 0; o < 4; o++) {
+                if ((nw[i + o] & ~old[i + o]) != 0)
+                    return NOR_ERASE;
+            }
+            ret = NOR_PROGRAM;
         }
-        i--;
-        first = i;
-        i = first;
-        //printf("first = %d\n", first);
-        while ((i < mtd->numeraseregions) && 
-            ((ofs +len) >= regions[i].offset)) {
+        i *= 4;
+    }
+    for (; i < len; i++) {
+        o = ((const u_char *)old)[i];
+        n = new[i];
+        if (o != n) {
+            if ((n & ~o) != 0)
+                return NOR_ERASE;
+            ret = NOR_PROGRAM;
+        }
+    }
+    return ret;
+}
+
+FAST_FUNC static int
+nor_blank(const u32 *p, u32 len)
+{
+    u32 i, v = ~0;
+
+    for (i = 0; i < len / 4; i++)
+        v &= p[i];
+    return v == ~0;
+}
+
+static int
+nor_read_chunk(struct mtd_info *mtd, u32 ofs, u32 len)
+{
+    size_t retlen;
+
+    if (mtd->read(mtd, ofs, len, &retlen, (u_char *)nor_chunk) ||
+        retlen != len)
+        return -1;
+    return 0;
+}
+
+/*
+ * Program the bytes of new that differ from old (NULL: erased flash).
+ * Short runs of equal bytes are programmed along, which NOR allows.
+ */
+static int
+nor_program_delta(struct mtd_info *mtd, u32 ofs, const u_char *new,
+                  const u_char *old, u32 len)
+{
+    size_t retlen;
+    u32 i = 0, start, end;
+
+    while (i < len) {
+        while (i < len && new[i] == (old ? old[i] : 0xff))
             i++;
+        if (i == len)
+            break;
+        start = i;
+        end = ++i;
+        for (; i < len && i - end < NOR_GAP; i++) {
+            if (new[i] != (old ? old[i] : 0xff))
+                end = i + 1;
         }
-        i--;
-        last = i;
-        //printf("first = %d, last = %d\n", first, last);
-
-        retlen = 0;
-        for (i = first; i <= last; i++) {
-            for (j = 0; j < regions[i].numblocks; j++) {
-                if (len > regions[i].erasesize) {
-                    retlen +=  regions[i].erasesize;
-                    len -= regions[i].erasesize;
-                    //printf("retlen = 0x%x\n", retlen);
-                } else {
-                    retlen += regions[i].erasesize;
-                    //printf("Oh..! retlen = 0x%x\n", retlen);
-                    return retlen;
-                }
-            }
+        if (mtd->write(mtd, ofs + start, end - start, &retlen, new + start) ||
+            retlen != end - start)
+            return -1;
+        i = end;
+    }
+    return 0;
+}
+
+/*
+ * Write len bytes inside one erase block: skip it if the flash already
+ * holds the data, program it without erasing if only 1 -> 0 bits
+ * change (a blank block always can), else erase the block first and
+ * program back what it held outside the span.
+ */
+static int
+nor_write_block(struct mtd_info *mtd, u32 ofs, u32 len, const u_char *buf,
+                u32 blk_start, u32 blk_size, nor_stat_t *st)
+{
+    struct erase_info erase;
+    size_t retlen;
+    u32 pos, n, head, tail;
+    int how = NOR_SAME, ret;
+
+    for (pos = 0; pos < len && how != NOR_ERASE; pos += n) {
+        n = (len - pos < NOR_CHUNK) ? len - pos : NOR_CHUNK;
+        if (nor_read_chunk(mtd, ofs + pos, n))
+            return -1;
+        ret = nor_compare(nor_chunk, buf + pos, n);
+        if (ret > how)
+            how = ret;
+    }
+
+    switch (how) {
+    case NOR_SAME:
+        st->skipped++;
+        return 0;
+    case NOR_PROGRAM:
+        for (pos = 0; pos < len; pos += n) {
+            n = (len - pos < NOR_CHUNK) ? len - pos : NOR_CHUNK;
+            if (nor_read_chunk(mtd, ofs + pos, n) ||
+                nor_program_delta(mtd, ofs + pos, buf + pos,
+                                  (const u_char *)nor_chunk, n))
+                return -1;
         }
         break;
-
     default:
-        printf("Something wrong\n");
-        return 0;
+        head = ofs - blk_start;
+        tail = blk_size - head - len;
+        if (head || tail) {
+            if (nor_save_size < blk_size) {
+                nor_save = kmalloc(blk_size);
+                if (nor_save == NULL)
+                    return -1;
+                nor_save_size = blk_size;
+            }
+            if (mtd->read(mtd, blk_start, blk_size, &retlen, nor_save) ||
+                retlen != blk_size)
+                return -1;
+        }
+        memset(&erase, 0, sizeof(erase));
+        erase.mtd = mtd;
+        erase.addr = blk_start;
+        erase.len = blk_size;
+        if (mtd->erase(mtd, &erase))
+            return -1;
+        st->erased++;
+        if (nor_program_delta(mtd, ofs, buf, NULL, len))
+            return -1;
+        if ((head || tail) &&
+            (nor_program_delta(mtd, blk_start, nor_save, NULL, head) ||
+             nor_program_delta(mtd, ofs + len, nor_save + head + len,
+                               NULL, tail)))
+            return -1;
+        break;
     }
-
+    st->programmed++;
     return 0;
 }
 
+/*
+ * JFFS2 must not find old nodes after the image: erase the blocks of
+ * the partition after it which are not blank
+ */
 static int
-do_format_jffs2(struct mtd_info *mtd, loff_t ofs, size_t len)
+do_format_jffs2(struct mtd_info *mtd, loff_t ofs, size_t len, nor_stat_t *st)
 {
-    int ret;
     mtd_partition_t *usr;
     struct erase_info erase;
+    u32 pos, end, blk_start, blk_size, i;
 
     usr = find_mtd_partition((ulong)ofs);
     if (usr == NULL) {
@@ -145,17 +315,36 @@ do_format_jffs2(struct mtd_info *mtd, loff_t ofs, size_t len)
         return -1;
     }
 
-    erase.addr = usr->offset;
-    erase.len = usr->size;
-
     printf("Formating... ");
-    ret = mtd->erase(mtd, &erase);
-    if (ret) {
-        printf(" ... failed\n");
-        return ret;
+    end = usr->offset + usr->size;
+    pos = ofs + len;
+    if (len > 0 && mtd_block(mtd, ofs + len - 1, &blk_start, &blk_size) >= 0)
+        pos = blk_start + blk_size;
+    for (; pos < end; pos = blk_start + blk_size) {
+        if (mtd_block(mtd, pos, &blk_start, &blk_size) < 0)
+            break;
+        for (i = 0; i < blk_size; i += NOR_CHUNK) {
+            if (nor_read_chunk(mtd, blk_start + i, NOR_CHUNK))
+                goto failed;
+            if (!nor_blank(nor_chunk, NOR_CHUNK))
+                break;
+        }
+        if (i >= blk_size)
+            continue;
+        memset(&erase, 0, sizeof(erase));
+        erase.mtd = mtd;
+        erase.addr = blk_start;
+        erase.len = blk_size;
+        if (mtd->erase(mtd, &erase))
+            goto failed;
+        st->erased++;
     }
     printf(" ... done\n");
     return 0;
+
+failed:
+    printf(" ... failed at 0x%08lx\n", blk_start);
+    return -1;
 }
 
 static int
@@ -189,59 +378,50 @@ nor_lock(struct mtd_info *mtd, loff_t ofs, size_t len)
 }
 
 static int
-nor_erase(struct mtd_info *mtd, loff_t ofs, size_t len)
+nor_write(struct mtd_info *mtd, loff_t ofs, size_t len,
+          const u_char *buf, nor_stat_t *st)
 {
-    int ret;
-    struct erase_info erase;
-    erase.addr = ofs;
-    erase.len = len;
+    u32 pos, n, blk_start, blk_size;
 
-    printf("Erasing...   ");
-    ret = mtd->erase(mtd, &erase);
-    if (ret) {
-        printf(" ... failed\n");
-        return ret;
-    }
-    printf(" ... done\n");
-    return 0;
-}
-
-static int
-nor_write(struct mtd_info *mtd, loff_t ofs, size_t len, 
-          const u_char * buf)
-{
-    int ret;
-    __u32 retlen = 0;
     printf("Writing...   ");
-    retlen = 0;
-    ret = mtd->write(mtd, ofs, len, &retlen, buf);
-    if ((ret < 0) || (retlen != len)) {
-        printf(" ... failed\n\tretlen = %d, ret = %d\n", retlen, ret);
-        return ret;
+    for (pos = ofs; pos < ofs + len; pos += n) {
+        if (mtd_block(mtd, pos, &blk_start, &blk_size) < 0) {
+            printf(" ... failed\n\tno erase block at 0x%08lx\n", pos);
+            return -1;
+        }
+        n = blk_start + blk_size - pos;
+        if (n > ofs + len - pos)
+            n = ofs + len - pos;
+        if (nor_write_block(mtd, pos, n, buf + (pos - ofs), 
+                            blk_start, blk_size, st)) {
+            printf(" ... failed\n\tblock = 0x%08lx\n", blk_start);
+            return -1;
+        }
     }
     printf(" ... done\n");
     return 0;
 }
 
 static int
-nor_verify(const u_char *buf, loff_t ofs,  size_t len)
+nor_verify(struct mtd_info *mtd, const u_char *buf, loff_t ofs, size_t len)
 {
-    int ret;
+    u32 pos, n, i;
 
     printf("Verifying... ");
-#ifdef CONFIG_MSG_PROGRESS
-    ret = mem_compare(buf, (u_char*)(ulong)(ofs + FLASH_UNCACHED_BASE), 
-              len, 1);
-#else
-    ret = mem_compare(buf, (u_char*)(ulong)(ofs + FLASH_UNCACHED_BASE), 
-              len, 0);
-#endif
-    if (ret != len) {
-        printf(" ... failed\n\tnot mached. offset = 0x%08lx, ", ret);
-        printf("\tsrc = 0x%08lx, dst = 0x%08lx\n", 
-            *(ulong *)((ulong)(buf + ret)), 
-            *(ulong *)((ulong)(ofs + ret)));
-        return -1;
+    for (pos = 0; pos < len; pos += n) {
+        n = (len - pos < NOR_CHUNK) ? len - pos : NOR_CHUNK;
+        if (nor_read_chunk(mtd, ofs + pos, n)) {
+            printf(" ... failed\n\tread error at 0x%08lx\n", (u32)ofs + pos);
+            return -1;
+        }
+        if (nor_compare(nor_chunk, buf + pos, n) != NOR_SAME) {
+            for (i = 0; ((u_char *)nor_chunk)[i] == buf[pos + i]; i++)
+                ;
+            printf(" ... failed\n\tnot mached. offset = 0x%08lx, ", pos + i);
+            printf("\tsrc = 0x%02x, dst = 0x%02x\n",
+                buf[pos + i], ((u_char *)nor_chunk)[i]);
+            return -1;
+        }
     }
     printf(" ... done\n");
     return 0;
@@ -252,13 +432,12 @@ make_steps(ws_state_t *steps, int flag)
 {
     int i, temp, num_step;
 
-    steps[0] = WS_ERASING;
-    steps[1] = WS_WRITING;
-    steps[2] = WS_VERIFYING;
-    num_step = 3;
+    steps[0] = WS_WRITING;
+    steps[1] = WS_VERIFYING;
+    num_step = 2;
 
     if (flag & MF_JFFS2) {
-        steps[0] = WS_FM_JFFS2;
+        steps[num_step++] = WS_FM_JFFS2;
     }
     if (flag & MF_LOCKED) {
         temp = num_step;
@@ -282,10 +461,12 @@ write_to_nor(struct mtd_info *mtd, loff_t ofs, size_t len,
     ws_state_t steps[10];
     int num_step = 0, i;
     size_t blk_size = find_erase_size(mtd, ofs, len);
+    nor_stat_t st;
 
     printf("Found block size = 0x%08lx\n", blk_size);
 
     num_step = make_steps(steps, flag);
+    memset(&st, 0, sizeof(st));
 
     for (i = 0; i <= num_step; i++) {
         switch(steps[i]) {
@@ -298,19 +479,15 @@ write_to_nor(struct mtd_info *mtd, loff_t ofs, size_t len,
             if (ret) steps[i+1] = WS_ERROR;
             break;
         case WS_FM_JFFS2:
-            ret = do_format_jffs2(mtd, ofs, len);
+            ret = do_format_jffs2(mtd, ofs, len, &st);
             if (ret) steps[i+1] = WS_ERROR;
             break;
-        case WS_ERASING:
-            ret = nor_erase(mtd, ofs, blk_size);
-            if (ret) steps[i+1] = WS_ERROR;
-            break; 
         case WS_WRITING:
-            ret = nor_write(mtd, ofs, len, buf);
+            ret = nor_write(mtd, ofs, len, buf, &st);
             if (ret) steps[i+1] = WS_ERROR;
             break;
         case WS_VERIFYING:
-            ret = nor_verify(buf, ofs, len);
+            ret = nor_verify(mtd, buf, ofs, len);
             if (ret) steps[i+1] = WS_ERROR;
             break;
         case WS_ERROR:
@@ -318,6 +495,8 @@ write_to_nor(struct mtd_info *mtd, loff_t ofs, size_t len,
             return -1;
         case WS_DONE:
             printf("Written %d bytes\n", len);
+            printf("Blocks: %d skipped, %d erased, %d programmed\n",
+                st.skipped, st.erased, st.programmed);
             return 0;
         default:
             printf("Error while writing a image.\n");
@@ -333,9 +512,11 @@ write_to_nor(struct mtd_info *mtd, loff_t ofs, size_t len,
  *
  * There are five stages.
  *    Stage 1: Unlock a region if you want.
- *    Stage 2: Erase a region.
- *    Stage 3: Write the buffer to a region.
- *    Stage 4: Verify result of previous stage.
+ *    Stage 2: Write the buffer to a region, block by block.  Blocks
+ *             which already hold the data are skipped, and a block
+ *             is only erased if some bit must go from 0 to 1.
+ *    Stage 3: Verify result of previous stage.
+ *    Stage 4: Erase the rest of a JFFS2 partition.
  *    Stage 5: Lock a region if you want.
  *
  * Arguments:
@@ -356,8 +537,7 @@ int write_to_flash(loff_t ofs, size_t len, const u_char *buf, int flag)
 
     switch (mtd->type) {
     case MTD_NORFLASH:
-        write_to_nor(mtd, ofs, len, buf, flag);
-        break;
+        return write_to_nor(mtd, ofs, len, buf, flag);
     default:
         printf("Not support this MTD\n");
         return -1;
@@ -380,6 +560,7 @@ static void command_erase(int argc, const char **argv)
 
     if ((argc != 2) && (argc != 3)) {
         printf("invalid 'flash erase' command: too few(many) arguments\n");
+        cmd_status = -1;
         return;
     }
 
@@ -387,6 +568,7 @@ static void command_erase(int argc, const char **argv)
         mtd_partition_t *part = get_mtd_partition(argv[1]);
         if (part == NULL) {
             printf("Could not found partition \"%s\"\n", argv[1]);
+            cmd_status = -1;
             return;
         }
         printf("Erasing \"%s\" parittion\n", argv[1]);
@@ -405,9 +587,10 @@ do_erase:
     printf("Erasing block from 0x%08lx to 0x%08lx... ", 
         instr.addr, instr.addr + instr.len);
     ret = mtd->erase(mtd, &instr);
-    if (ret < 0)
+    if (ret < 0) {
         printf(" ... failed\n");
-    else
+        cmd_status = -1;
+    } else
         printf(" ... done\n");
 }
 
@@ -509,18 +692,20 @@ void command_flash(int argc, const char **argv)
 {
     if (mymtd == NULL) {
         printf("Error: Can not find MTD information\n");
+        cmd_status = -1;
         return;
     }
 
     if (argc == 1) {
         printf("invalid 'flash' command: too few arguments\n");
         command_help(0, NULL);
+        cmd_status = -1;
         return;
     }
     execsubcmd(flash_cmds, argc-1, argv+1);
 }
 
-static user_command_t flash_cmd = {
+USER_CMD(flash_cmd) = {
     "flash",
     command_flash,
     NULL,
@@ -541,7 +726,5 @@ int mtd_dev_init(void)
 #endif
     ret = mtd_init();
 
-    add_command(&flash_cmd);
-
     return ret;
 }
@@ -68,12 +68,27 @@ int *nb_mtd_parts = (int *)(VIVI_PRIV_RAM_BASE + MTD_PART_OFFSET + 8);
  * General Interface
  */
 
+/*
+ * number of partitions, 0 until init_priv_data() has set up the table
+ */
+static int mtd_part_count(void)
+{
+    const char *magic = (const char *)(VIVI_PRIV_RAM_BASE + MTD_PART_OFFSET);
+    int num = *nb_mtd_parts;
+
+    if (strncmp(magic, mtd_part_magic, 8) != 0)
+        return 0;
+    if (num < 0 || num > (MTD_PART_SIZE - 16) / sizeof(mtd_partition_t))
+        return 0;
+    return num;
+}
+
 /*
  * get a mtd partition by name
  */
 mtd_partition_t *get_mtd_partition(const char *name)
 {
-    int i, num = *nb_mtd_parts;
+    int i, num = mtd_part_count();
     mtd_partition_t *parts = mtd_parts;
 
     for (i = 0; i < num; i++, parts++) {
@@ -90,7 +105,7 @@ mtd_partition_t *get_mtd_partition(const char *name)
  */
 mtd_partition_t *find_mtd_partition(ulong ofs)
 {
-    int i, num = *nb_mtd_parts;
+    int i, num = mtd_part_count();
     mtd_partition_t *parts = mtd_parts;
 
     for (i = 0; i < num; i++, parts++) {
@@ -153,7 +168,7 @@ int reset_mtd_partition(void)
 void display_mtd_partition(void)
 {
     mtd_partition_t *parts = mtd_parts;
-    int i, nb_parts = *(nb_mtd_parts);
+    int i, nb_parts = mtd_part_count();
 
     printf("Number of partitions: %d\n", nb_parts);
           /*name            :       offset          size            flag*/
@@ -350,7 +365,7 @@ void command_part(int argc, const char **argv)
     execsubcmd(part_cmds, argc-1, argv+1);
 }
 
-user_command_t part_cmd = {
+USER_CMD(part_cmd) = {
     "part", 
     command_part, 
     NULL,
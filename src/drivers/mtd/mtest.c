@@ -0,0 +1,480 @@
+/*
+ * mtest.c: DDR memory test
+ *
+ * Tests, in this order:
+ *
+ *   data bus      walking ones and zeros on both words of a 64-bit beat
+ *   address bus   each address line stuck high, stuck low or shorted
+ *   fill          solid patterns written and read back
+ *   inversions    moving inversions: verify and invert up, then down
+ *   random        xorshift32 stream written and regenerated to verify
+ *
+ * Bulk tests work a cache line at a time.  With the data cache on, a
+ * line is allocated with dcbz instead of being read from DDR before it
+ * is written, and a zero fill is dcbz alone.  The range is processed in
+ * MT_CHUNK pieces, between which a key hit stops the test.
+ *
+ * Failing addresses are printed up to a limit, then only counted.
+ * Throughput is given in MB/s of data written plus data read.
+ */
+
+#include "command.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wrboot.h>
+#include <types.h>
+
+#define MT_LINE             32              /* e500 cache line */
+#define MT_CHUNK            SZ_1M
+#define MT_MAX_PRINT        16              /* default failing addresses shown */
+#define MT_SPR_L1CSR0       1010
+#define MT_L1CSR0_CE        0x00000001      /* data cache enable */
+
+static u32 mt_errors;
+static u32 mt_max_print;
+static int mt_dcbz;
+static int mt_abort;
+static u32 mt_tb_khz;
+static u32 mt_tb_hi, mt_tb_lo;
+
+static const u32 mt_patterns[] = {
+    0x00000000, 0xffffffff, 0x55555555, 0xaaaaaaaa, 0x33333333, 0xcccccccc
+};
+
+/*
+ * Fixed RAM areas inside the heap range (h/command.h), kept out of the
+ * default range: stack, private data (partition table, parameters,
+ * Linux command line), MMU table, heap and image.  Line aligned.
+ */
+static const struct {
+    u32 base;
+    u32 size;
+} mt_reserved[] = {
+    { STACK_BASE, DRAM_BASE + DRAM_SIZE - STACK_BASE },
+};
+
+/*
+ * Helpers
+ */
+static void mt_fail(volatile u32 *addr, u32 expect, u32 actual)
+{
+    if (mt_errors++ < mt_max_print)
+        printf("    0x%08lx: expected 0x%08lx, read 0x%08lx\n",
+            addr, expect, actual);
+}
+
+static int mt_dcache_on(void)
+{
+    u32 v;
+
+    __asm__ volatile ("mfspr %0, %1" : "=r" (v) : "i" (MT_SPR_L1CSR0));
+    return (v & MT_L1CSR0_CE) != 0;
+}
+
+static void mt_tb_get(u32 *hi, u32 *lo)
+{
+    u32 u, l, u2;
+
+    do {
+        __asm__ volatile ("mfspr %0, 269" : "=r" (u));
+        __asm__ volatile ("mfspr %0, 268" : "=r" (l));
+        __asm__ volatile ("mfspr %0, 269" : "=r" (u2));
+    } while (u != u2);
+    *hi = u;
+    *lo = l;
+}
+
+static void mt_timer_start(void)
+{
+    mt_tb_get(&mt_tb_hi, &mt_tb_lo);
+}
+
+/* milliseconds since mt_timer_start(): 64/32 division, there is no libgcc */
+static u32 mt_timer_ms(void)
+{
+    u32 hi, lo, q = 0, rem = 0;
+    int i;
+
+    mt_tb_get(&hi, &lo);
+    hi -= mt_tb_hi + (lo < mt_tb_lo);
+    lo -= mt_tb_lo;
+
+    for (i = 63; i >= 0; i--) {
+        rem = (rem << 1) | (((i >= 32 ? hi >> (i - 32) : lo >> i)) & 1);
+        q <<= 1;
+        if (rem >= mt_tb_khz) {
+            rem -= mt_tb_khz;
+            q |= 1;
+        }
+    }
+    return q ? q : 1;
+}
+
+static int mt_poll_abort(void)
+{
+    if (!mt_abort && tstc()) {
+        (void)getc();
+        mt_abort = 1;
+    }
+    return mt_abort;
+}
+
+static void mt_report(const char *name, u32 pattern, int has_pattern,
+              u32 bytes_moved_kib, u32 errors_before)
+{
+    u32 ms = mt_timer_ms();
+
+    if (has_pattern)
+        printf("  %-12s 0x%08lx", name, pattern);
+    else
+        printf("  %-23s", name);
+    printf(" %6d MB/s", (bytes_moved_kib / ms) * 125 / 128);
+    if (mt_abort)
+        printf("  aborted\n");
+    else if (mt_errors != errors_before)
+        printf("  %d errors\n", mt_errors - errors_before);
+    else
+        printf("  ok\n");
+}
+
+/*
+ * Cache line kernels
+ */
+FAST_FUNC static void mt_fill(u32 *p, u32 bytes, u32 pat, int dcbz)
+{
+    u32 *end = p + bytes / sizeof(u32);
+
+    for (; p < end; p += MT_LINE / sizeof(u32)) {
+        if (dcbz) {
+            __asm__ volatile ("dcbz 0, %0" : : "r" (p) : "memory");
+            if (pat == 0)
+                continue;
+        }
+        p[0] = pat; p[1] = pat; p[2] = pat; p[3] = pat;
+        p[4] = pat; p[5] = pat; p[6] = pat; p[7] = pat;
+    }
+}
+
+/* returns the first line that does not match, or NULL */
+FAST_FUNC static u32 *mt_check(u32 *p, u32 bytes, u32 pat)
+{
+    u32 *end = p + bytes / sizeof(u32);
+
+    for (; p < end; p += MT_LINE / sizeof(u32)) {
+        if (((p[0] ^ pat) | (p[1] ^ pat) | (p[2] ^ pat) | (p[3] ^ pat) |
+             (p[4] ^ pat) | (p[5] ^ pat) | (p[6] ^ pat) | (p[7] ^ pat)) != 0)
+            return p;
+    }
+    return NULL;
+}
+
+/* verify pat and write ~pat, one line up; returns a failing line or NULL */
+FAST_FUNC static u32 *mt_invert_up(u32 *p, u32 bytes, u32 pat)
+{
+    u32 *end = p + bytes / sizeof(u32);
+    u32 inv = ~pat;
+
+    for (; p < end; p += MT_LINE / sizeof(u32)) {
+        if (((p[0] ^ pat) | (p[1] ^ pat) | (p[2] ^ pat) | (p[3] ^ pat) |
+             (p[4] ^ pat) | (p[5] ^ pat) | (p[6] ^ pat) | (p[7] ^ pat)) != 0)
+            return p;
+        p[0] = inv; p[1] = inv; p[2] = inv; p[3] = inv;
+        p[4] = inv; p[5] = inv; p[6] = inv; p[7] = inv;
+    }
+    return NULL;
+}
+
+/* same, from the top line down */
+FAST_FUNC static u32 *mt_invert_down(u32 *p, u32 bytes, u32 pat)
+{
+    u32 *q = p + bytes / sizeof(u32);
+    u32 inv = ~pat;
+
+    while (q > p) {
+        q -= MT_LINE / sizeof(u32);
+        if (((q[0] ^ pat) | (q[1] ^ pat) | (q[2] ^ pat) | (q[3] ^ pat) |
+             (q[4] ^ pat) | (q[5] ^ pat) | (q[6] ^ pat) | (q[7] ^ pat)) != 0)
+            return q;
+        q[7] = inv; q[6] = inv; q[5] = inv; q[4] = inv;
+        q[3] = inv; q[2] = inv; q[1] = inv; q[0] = inv;
+    }
+    return NULL;
+}
+
+#define MT_XORSHIFT(x)  ((x) ^= (x) << 13, (x) ^= (x) >> 17, (x) ^= (x) << 5)
+
+FAST_FUNC static void mt_fill_random(u32 *p, u32 bytes, u32 *seed, int dcbz)
+{
+    u32 *end = p + bytes / sizeof(u32);
+    u32 x = *seed;
+    int i;
+
+    for (; p < end; p += MT_LINE / sizeof(u32)) {
+        if (dcbz)
+            __asm__ volatile ("dcbz 0, %0" : : "r" (p) : "memory");
+        for (i = 0; i < MT_LINE / sizeof(u32); i++)
+            p[i] = MT_XORSHIFT(x);
+    }
+    *seed = x;
+}
+
+FAST_FUNC static void mt_check_random(u32 *p, u32 bytes, u32 *seed)
+{
+    u32 *end = p + bytes / sizeof(u32);
+    u32 x = *seed;
+
+    for (; p < end; p++) {
+        MT_XORSHIFT(x);
+        if (*p != x)
+            mt_fail(p, x, *p);
+    }
+    *seed = x;
+}
+
+/* report each word of a line that failed a solid pattern */
+static void mt_fail_line(u32 *line, u32 pat)
+{
+    int i;
+
+    for (i = 0; i < MT_LINE / sizeof(u32); i++)
+        if (line[i] != pat)
+            mt_fail(&line[i], pat, line[i]);
+}
+
+/*
+ * Tests
+ */
+static void mt_data_bus(volatile u32 *p)
+{
+    u32 before = mt_errors, pat;
+    int i, w;
+
+    /* both 32-bit halves of the 64-bit DDR data bus */
+    for (w = 0; w < 2; w++) {
+        for (i = 0; i < 32; i++) {
+            pat = 1 << i;
+            p[w] = pat;
+            p[w + 2] = ~pat;    /* drive the bus the other way */
+            if (p[w] != pat)
+                mt_fail(&p[w], pat, p[w]);
+            p[w] = ~pat;
+            p[w + 2] = pat;
+            if (p[w] != ~pat)
+                mt_fail(&p[w], ~pat, p[w]);
+        }
+    }
+    printf("  %-23s %s\n", "data bus", (mt_errors != before) ? "failed" : "ok");
+}
+
+static void mt_addr_bus(volatile u32 *base, u32 bytes)
+{
+    u32 nwords = bytes / sizeof(u32);
+    u32 before = mt_errors;
+    u32 pat = 0xaaaaaaaa, anti = 0x55555555;
+    u32 ofs, test;
+
+    for (ofs = 1; ofs < nwords; ofs <<= 1)
+        base[ofs] = pat;
+
+    /* stuck high: writing the base must not change any other word */
+    base[0] = anti;
+    for (ofs = 1; ofs < nwords; ofs <<= 1)
+        if (base[ofs] != pat)
+            mt_fail(&base[ofs], pat, base[ofs]);
+    base[0] = pat;
+
+    /* stuck low or shorted: each line on its own */
+    for (test = 1; test < nwords; test <<= 1) {
+        base[test] = anti;
+        if (base[0] != pat)
+            mt_fail(&base[0], pat, base[0]);
+        for (ofs = 1; ofs < nwords; ofs <<= 1)
+            if (ofs != test && base[ofs] != pat)
+                mt_fail(&base[ofs], pat, base[ofs]);
+        base[test] = pat;
+    }
+    printf("  %-23s %s\n", "address bus", (mt_errors != before) ? "failed" : "ok");
+}
+
+static void mt_solid(u8 *base, u32 bytes, u32 pat)
+{
+    u32 before = mt_errors, ofs, n;
+    u32 *line;
+
+    mt_timer_start();
+    for (ofs = 0; ofs < bytes && !mt_poll_abort(); ofs += n) {
+        n = (bytes - ofs < MT_CHUNK) ? bytes - ofs : MT_CHUNK;
+        mt_fill((u32 *)(base + ofs), n, pat, mt_dcbz);
+    }
+    for (ofs = 0; ofs < bytes && !mt_poll_abort(); ofs += n) {
+        n = (bytes - ofs < MT_CHUNK) ? bytes - ofs : MT_CHUNK;
+        line = (u32 *)(base + ofs);
+        while ((line = mt_check(line, base + ofs + n - (u8 *)line, pat)) != NULL) {
+            mt_fail_line(line, pat);
+            line += MT_LINE / sizeof(u32);
+        }
+    }
+    mt_report("fill", pat, 1, (bytes >> 10) * 2, before);
+}
+
+static void mt_inversions(u8 *base, u32 bytes, u32 pat)
+{
+    u32 before = mt_errors, ofs, n, top;
+    u32 *line, *chunk;
+
+    mt_timer_start();
+    for (ofs = 0; ofs < bytes && !mt_poll_abort(); ofs += n) {
+        n = (bytes - ofs < MT_CHUNK) ? bytes - ofs : MT_CHUNK;
+        mt_fill((u32 *)(base + ofs), n, pat, mt_dcbz);
+    }
+    for (ofs = 0; ofs < bytes && !mt_poll_abort(); ofs += n) {
+        n = (bytes - ofs < MT_CHUNK) ? bytes - ofs : MT_CHUNK;
+        line = (u32 *)(base + ofs);
+        while ((line = mt_invert_up(line, base + ofs + n - (u8 *)line, pat)) != NULL) {
+            mt_fail_line(line, pat);
+            mt_fill(line, MT_LINE, ~pat, 0);
+            line += MT_LINE / sizeof(u32);
+        }
+    }
+    for (ofs = bytes; ofs > 0 && !mt_poll_abort(); ofs -= n) {
+        n = (ofs < MT_CHUNK) ? ofs : MT_CHUNK;
+        chunk = (u32 *)(base + ofs - n);
+        top = n;
+        /* resume below each failing line */
+        while ((line = mt_invert_down(chunk, top, ~pat)) != NULL) {
+            mt_fail_line(line, ~pat);
+            mt_fill(line, MT_LINE, pat, 0);
+            top = (u8 *)line - (u8 *)chunk;
+        }
+    }
+    mt_report("inversions", pat, 1, (bytes >> 10) * 5, before);
+}
+
+static void mt_random(u8 *base, u32 bytes, u32 seed)
+{
+    u32 before = mt_errors, ofs, n, x;
+
+    mt_timer_start();
+    x = seed;
+    for (ofs = 0; ofs < bytes && !mt_poll_abort(); ofs += n) {
+        n = (bytes - ofs < MT_CHUNK) ? bytes - ofs : MT_CHUNK;
+        mt_fill_random((u32 *)(base + ofs), n, &x, mt_dcbz);
+    }
+    x = seed;
+    for (ofs = 0; ofs < bytes && !mt_poll_abort(); ofs += n) {
+        n = (bytes - ofs < MT_CHUNK) ? bytes - ofs : MT_CHUNK;
+        mt_check_random((u32 *)(base + ofs), n, &x);
+    }
+    mt_report("random", seed, 1, (bytes >> 10) * 2, before);
+}
+
+/*
+ * Cut the fixed areas out of a range, keeping the larger part around
+ * each of them
+ */
+static void mt_exclude(u8 **base, u32 *len)
+{
+    u32 lo, hi, r_lo, r_hi, below, above, i;
+
+    for (i = 0; i < ARRAY_SIZE(mt_reserved); i++) {
+        lo = (u32)*base;
+        hi = lo + *len;
+        r_lo = mt_reserved[i].base;
+        r_hi = r_lo + mt_reserved[i].size;
+        if (r_hi <= lo || r_lo >= hi)
+            continue;
+        below = (r_lo > lo) ? r_lo - lo : 0;
+        above = (r_hi < hi) ? hi - r_hi : 0;
+        if (below >= above) {
+            *len = below;
+        } else {
+            *base = (u8 *)r_hi;
+            *len = above;
+        }
+    }
+}
+
+/*
+ * vivi> mtest [-n <passes>] [-e <max errors shown>] [<addr> <len>]
+ */
+static void command_mtest(int argc, const char **argv)
+{
+    u8 *buf, *base;
+    u32 len, pass, passes = 1, i;
+    unsigned long avail;
+
+    mt_max_print = MT_MAX_PRINT;
+    while (argc > 2 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-n") == 0)
+            passes = strtoul(argv[2], NULL, 0);
+        else if (strcmp(argv[1], "-e") == 0)
+            mt_max_print = strtoul(argv[2], NULL, 0);
+        else
+            break;
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc == 3) {
+        base = (u8 *)((strtoul(argv[1], NULL, 0) + MT_LINE - 1) & ~(MT_LINE - 1));
+        len = strtoul(argv[2], NULL, 0) & ~(MT_LINE - 1);
+    } else if (argc == 1) {
+        /* the largest free block of the heap, tested in place: nothing
+         * is allocated while mtest runs, and it stays free afterwards.
+         * The heap covers DDR, so the fixed areas in it are left out. */
+        buf = kmalloc_max(&avail);
+        len = 0;
+        if (buf != NULL && avail > MT_LINE) {
+            base = (u8 *)(((u32)buf + MT_LINE - 1) & ~(MT_LINE - 1));
+            len = (avail - (base - buf)) & ~(MT_LINE - 1);
+            mt_exclude(&base, &len);
+        }
+        if (len < SZ_1M) {
+            printf("mtest: no memory to test\n");
+            cmd_status = -1;
+            return;
+        }
+    } else {
+        printf("invalid 'mtest' command: wrong arguments\n");
+        printf("Usage: mtest [-n <passes>] [-e <max errors shown>] [<addr> <len>]\n");
+        cmd_status = -1;
+        return;
+    }
+    if (len < 4 * MT_LINE) {
+        printf("mtest: range too small\n");
+        cmd_status = -1;
+        return;
+    }
+
+    mt_tb_khz = sysTimeBaseFreqGet() / 1000;
+    mt_dcbz = mt_dcache_on();
+    mt_errors = 0;
+    mt_abort = 0;
+
+    printf("mtest: 0x%08lx-0x%08lx (%dK), %d pass(es), dcbz %s, any key stops\n",
+        base, base + len - 1, len >> 10, passes, mt_dcbz ? "on" : "off");
+
+    for (pass = 1; (passes == 0 || pass <= passes) && !mt_abort; pass++) {
+        printf("pass %d\n", pass);
+        mt_data_bus((volatile u32 *)base);
+        mt_addr_bus((volatile u32 *)base, len);
+        for (i = 0; i < ARRAY_SIZE(mt_patterns) && !mt_abort; i++)
+            mt_solid(base, len, mt_patterns[i]);
+        for (i = 0; i < ARRAY_SIZE(mt_patterns) && !mt_abort; i += 2)
+            mt_inversions(base, len, mt_patterns[i]);
+        if (!mt_abort)
+            mt_random(base, len, 0x2545f491 + pass);
+    }
+
+    printf("mtest: %d error(s)%s\n", mt_errors, mt_abort ? ", stopped" : "");
+    if (mt_errors || mt_abort)
+        cmd_status = -1;
+}
+
+USER_CMD(mtest_cmd) = {
+    "mtest",
+    command_mtest,
+    NULL,
+    "mtest [-n <n>] [<addr> <len>] \t-- Test memory"
+};
@@ -57,12 +57,25 @@ char *linux_cmd_line = (char *)(VIVI_PRIV_RAM_BASE + LINUX_CMD_OFFSET + 8);
  * General Interfaces
  */
 
+/* number of parameters, 0 until init_priv_data() has set up the table */
+static int param_count(void)
+{
+    const char *magic = (const char *)(VIVI_PRIV_RAM_BASE + PARAMETER_TLB_OFFSET);
+    int num = *(nb_params);
+
+    if (strncmp(magic, vivi_param_magic, 8) != 0)
+        return 0;
+    if (num < 0 || num > (PARAMETER_TLB_SIZE - 16) / sizeof(vivi_parameter_t))
+        return 0;
+    return num;
+}
+
 /* get parameter data by name */
 vivi_parameter_t *get_param(const char *name)
 {
     int i, namelen;
     vivi_parameter_t *params = vivi_params;
-    int num = *(nb_params);
+    int num = param_count();
 
     namelen = strlen(name);
     for(i = 0; i < num; i++) {
@@ -98,7 +111,7 @@ int set_param_value(const char *name, param_value_t value)
 void display_param_tlb(void)
 {
     vivi_parameter_t *params = vivi_params;
-    int i, num = *(nb_params);
+    int i, num = param_count();
 
     printf("Number of parameters: %d\n", num);
     printf("%-24s:\t   hex\t\t   integer\n", "name");
@@ -154,7 +167,7 @@ void command_param(int argc, const char **argv)
     execsubcmd(param_cmds, argc-1, argv+1);
 }
 
-user_command_t param_cmd = {
+USER_CMD(param_cmd) = {
     "param",
     command_param,
     NULL,
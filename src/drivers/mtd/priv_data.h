@@ -61,4 +61,11 @@ void display_mtd_partition(void);
 int save_priv_data_blk(void);
 int init_priv_data(void);
 
+/* xmodem.c */
+typedef int (*xm_sink_t)(void *arg, u32 ofs, const u8 *data, u32 len);
+typedef void (*xm_idle_t)(void *arg);
+long xmodem_receive(char *buf, u32 size);
+long xmodem_receive_to(xm_sink_t sink, xm_idle_t idle, void *arg, u32 size);
+int ymodem_send(const char *buf, u32 len, const char *name);
+
 #endif /* __VIVI_PRIV_DATA_H__ */
@@ -453,7 +453,7 @@ void command_reset(int argc, const char **argv)
     processor_reset(0);
 }
 
-user_command_t reset_cmd = {
+USER_CMD(reset_cmd) = {
     "reset",
     command_reset,
     NULL,
@@ -508,7 +508,7 @@ print_usage:
     display_cpu_help();
 }
 
-user_command_t cpu_cmd = {
+USER_CMD(cpu_cmd) = {
     "cpu",
     command_cpu,
     NULL,
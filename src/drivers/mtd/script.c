@@ -0,0 +1,263 @@
+/*
+ * script.c: Run command scripts from memory, flash or the FAT volume
+ *
+ * A script is plain text, one command line per line, run as if it was
+ * typed at the prompt but without echo or prompt.  Blank lines and lines
+ * starting with '#' are skipped.  The text ends at the end of the file
+ * or partition, or at the first NUL or 0xff (erased flash) byte.
+ *
+ *   # update the kernel if the image is there, else report it
+ *   load flash kernel x && echo updated || exit 1
+ *   boot
+ *
+ * "exit [status]" ends the script.  Scripts can source other scripts.
+ *
+ * At power up, run_boot_script() runs the "script" MTD partition, or the
+ * boot.scr file of the FAT volume, unless a key is hit within a second.
+ */
+
+#include "command.h"
+#include "priv_data.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wrboot.h>
+#include <types.h>
+#include "mtd.h"
+
+#define SCRIPT_MAX_SIZE     SZ_16K
+#define SCRIPT_MAX_DEPTH    4
+#define SCRIPT_LINE_MAX     256
+
+#define BOOT_SCRIPT_PART    "script"
+#define BOOT_SCRIPT_FILE    "boot.scr"
+#define BOOT_SCRIPT_DELAY   100     /* x 10ms to hit a key */
+
+extern struct mtd_info *mymtd;
+extern long fload(const char *path, unsigned long addr, unsigned long size);
+extern void udelay(unsigned int delay);
+
+static int script_depth = 0;
+static int script_exit = 0;
+
+/* text of the scripts being run, one buffer per nesting level */
+static char *script_buf[SCRIPT_MAX_DEPTH];
+
+/*
+ * run_script(): run the command lines of a script
+ *
+ * Returns the status of the last command, or -1 if the script can not
+ * be run.
+ */
+int run_script(const char *text, unsigned long size, int verbose)
+{
+    char line[SCRIPT_LINE_MAX];
+    const char *end = text + size;
+    char *s;
+    int len, lineno = 0;
+    int status = 0;
+
+    if (script_depth >= SCRIPT_MAX_DEPTH) {
+        printf("script: nested too deep\n");
+        return -1;
+    }
+    script_depth++;
+
+    while (text < end && *text != '\0' && (u_char)*text != 0xff) {
+        for (len = 0; text + len < end && text[len] != '\n' &&
+                text[len] != '\0' && (u_char)text[len] != 0xff; len++)
+            ;
+        lineno++;
+        if (len >= SCRIPT_LINE_MAX) {
+            printf("script: line %d is too long\n", lineno);
+            status = -1;
+            break;
+        }
+        memcpy(line, text, len);
+        line[len] = '\0';
+        text += len;
+        if (text < end && *text == '\n')
+            text++;
+
+        if (len > 0 && line[len - 1] == '\r')
+            line[len - 1] = '\0';
+        for (s = line; *s == ' ' || *s == '\t'; s++)
+            ;
+        if (*s == '\0' || *s == '#')
+            continue;
+
+        if (verbose)
+            printf("+ %s\n", s);
+        status = exec_string(s);
+        if (script_exit) {
+            script_exit = 0;
+            break;
+        }
+    }
+
+    script_depth--;
+    return status;
+}
+
+/*
+ * script_load(): read a script from a MTD partition or a FAT file
+ *
+ * Returns the buffer of the current nesting level, allocated on first
+ * use and kept, or NULL.
+ */
+static char *script_load(const char *name, long *len_p, int quiet)
+{
+    mtd_partition_t *part;
+    char *buf;
+    size_t retlen;
+    long len;
+
+    if (script_depth >= SCRIPT_MAX_DEPTH) {
+        printf("source: nested too deep\n");
+        return NULL;
+    }
+    buf = script_buf[script_depth];
+    if (buf == NULL) {
+        buf = kmalloc(SCRIPT_MAX_SIZE);
+        if (buf == NULL) {
+            printf("source: out of memory\n");
+            return NULL;
+        }
+        script_buf[script_depth] = buf;
+    }
+
+    part = get_mtd_partition(name);
+    if (part != NULL) {
+        len = (part->size < SCRIPT_MAX_SIZE) ? part->size : SCRIPT_MAX_SIZE;
+        if (mymtd == NULL ||
+            mymtd->read(mymtd, part->offset, len, &retlen, (u_char *)buf) ||
+            retlen != len)
+            len = -1;
+    } else {
+        len = fload(name, (unsigned long)buf, SCRIPT_MAX_SIZE);
+    }
+
+    if (len < 0) {
+        if (!quiet)
+            printf("source: can not read '%s'\n", name);
+        return NULL;
+    }
+    *len_p = len;
+    return buf;
+}
+
+/*
+ * Power up script
+ */
+void run_boot_script(void)
+{
+    char *buf;
+    long len;
+    int i;
+
+    buf = script_load(BOOT_SCRIPT_PART, &len, 1);
+    if (buf == NULL)
+        buf = script_load(BOOT_SCRIPT_FILE, &len, 1);
+    if (buf == NULL)
+        return;
+    if (len == 0 || buf[0] == '\0' || (u_char)buf[0] == 0xff)
+        return;
+
+    printf("Hit any key to skip the boot script\n");
+    for (i = 0; i < BOOT_SCRIPT_DELAY; i++) {
+        if (tstc()) {
+            (void)getc();
+            return;
+        }
+        udelay(10000);
+    }
+
+    if (run_script(buf, len, 0) != 0)
+        printf("Boot script failed\n");
+}
+
+/*
+ * User commands
+ */
+
+/*
+ * vivi> source [-v] <addr>
+ * vivi> source [-v] <partition>
+ * vivi> source [-v] <file>
+ */
+static void command_source(int argc, const char **argv)
+{
+    unsigned long addr;
+    char *endp;
+    char *buf;
+    long len;
+    int verbose = 0;
+    int status;
+
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) {
+        verbose = 1;
+        argc--;
+        argv++;
+    }
+    if (argc != 2) {
+        printf("invalid 'source' command: too few(many) arguments\n");
+        printf("Usage: source [-v] <addr|partition|file>\n");
+        cmd_status = -1;
+        return;
+    }
+
+    /* a script in memory ends with a NUL */
+    addr = strtoul(argv[1], &endp, 0);
+    if (*endp == '\0') {
+        status = run_script((const char *)addr, SCRIPT_MAX_SIZE, verbose);
+    } else {
+        buf = script_load(argv[1], &len, 0);
+        if (buf == NULL) {
+            cmd_status = -1;
+            return;
+        }
+        status = run_script(buf, len, verbose);
+    }
+    cmd_status = status;
+}
+
+USER_CMD(source_cmd) = {
+    "source",
+    command_source,
+    NULL,
+    "source [-v] <addr|part|file> \t-- Run a command script"
+};
+
+static void command_exit(int argc, const char **argv)
+{
+    if (script_depth == 0) {
+        printf("exit: not in a script\n");
+        cmd_status = -1;
+        return;
+    }
+    script_exit = 1;
+    cmd_status = (argc > 1) ? (int)strtoul(argv[1], NULL, 0) : 0;
+}
+
+USER_CMD(exit_cmd) = {
+    "exit",
+    command_exit,
+    NULL,
+    "exit [<status>] \t\t\t-- End a script"
+};
+
+static void command_echo(int argc, const char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+        printf((i < argc - 1) ? "%s " : "%s", argv[i]);
+    printf("\n");
+}
+
+USER_CMD(echo_cmd) = {
+    "echo",
+    command_echo,
+    NULL,
+    "echo [<args>] \t\t\t-- Print the arguments"
+};
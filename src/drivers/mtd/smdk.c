@@ -113,36 +113,42 @@ mtd_partition_t default_mtd_partitions[] = {
 };
 #endif
 
+/* P2020RDB: 16MB NOR flash at 0xff000000, the boot loader in the last 1MB */
 mtd_partition_t default_mtd_partitions[] = {
     {
-        name:       "vivi",
-        offset:     0,
-        size:       0x00020000,
+        name:       "kernel",
+        offset:     0x00000000,
+        size:       0x00600000,
         flag:       0
     }, {
-        name:       "param",
-        offset:     0x00020000,
-        size:       0x00010000,
+        name:       "fat",      /* FatFs drive 0, see boot_init.c */
+        offset:     0x00600000,
+        size:       0x00800000,
         flag:       0
     }, {
-        name:       "kernel",
-        offset:     0x00030000,
-        size:       0x000C0000,
+        name:       "dtb",
+        offset:     0x00e00000,
+        size:       0x00080000,
         flag:       0
     }, {
-        name:       "root",
-        offset:     0x00100000,
-        size:       0x00140000,
-        flag:       MF_BONFS
+        name:       "script",
+        offset:     0x00e80000,
+        size:       0x00040000,
+        flag:       0
+    }, {
+        name:       "param",
+        offset:     0x00ec0000,
+        size:       0x00040000,
+        flag:       0
+    }, {
+        name:       "wrboot",
+        offset:     0x00f00000,
+        size:       0x00100000,
+        flag:       MF_LOCKED
     }
 };
 
-
-#if 0
 int default_nb_part = ARRAY_SIZE(default_mtd_partitions);
-#else
-int default_nb_part = 0xff;
-#endif
 
 #ifdef CONFIG_S3C2440_NAND_BOOT
 #define MT_S3C2440  MT_SMC_S3C2410
@@ -214,9 +220,7 @@ int board_init(void)
     return 0;
 }
 
-extern user_command_t cpu_cmd;
 int misc(void)
 {
-    add_command(&cpu_cmd);
     return 0;
 }
@@ -0,0 +1,650 @@
+/*
+ * xmodem.c: YMODEM-1K transfers over the console
+ *
+ * Packets are SOH (128 byte) or STX (1024 byte) blocks with a CRC16:
+ *
+ *   SOH|STX  blk  ~blk  data[128|1024]  crc_hi  crc_lo
+ *
+ * A batch starts with block 0, which holds the file name and its size
+ * in decimal, and ends with an empty block 0.  The sender waits for a
+ * 'C' (ACK after each block) or a 'G' from the receiver.  With 'G'
+ * (YMODEM-g) it streams the blocks without waiting for ACKs, and the
+ * transfer is cancelled if one is corrupted.
+ *
+ * The receiver also takes plain XMODEM-CRC (128 or 1K blocks, no block
+ * 0) and hands each block to a sink as it is acknowledged.  An idle
+ * hook runs while it waits for the line, which is how "load flash"
+ * erases and programs the flash while the transfer goes on.
+ *
+ * Transfers run on the console unless "baud -p 1" moves them to the
+ * second DUART channel.  On the console nothing else may be written
+ * while a transfer runs.  "baud -x <rate>" runs the transfers at
+ * another rate; the console is switched back when they are over.
+ */
+
+#include "command.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wrboot.h>
+#include <types.h>
+#include "priv_data.h"
+
+#define SOH                 0x01
+#define STX                 0x02
+#define EOT                 0x04
+#define ACK                 0x06
+#define NAK                 0x15
+#define CAN                 0x18
+#define CPMEOF              0x1a
+
+#define XM_TIMEOUT          (-1)
+#define XM_ERROR            (-2)
+#define XM_EOT              (-3)
+#define XM_CANCEL           (-4)
+
+#define XM_START_TRIES      60              /* x 1s for the other side */
+#define XM_RETRIES          10
+#define XM_BYTE_MS          1000
+#define XM_PACKET_MS        10000
+#define XM_NAME_MAX         64
+#define XM_BAUD_CONFIRM     10              /* seconds to answer "baud" */
+#define XM_CONSOLE          0               /* serial port 0 */
+
+extern int serial_port_present(int port);
+extern void serial_port_putc(int port, const char c);
+extern int serial_port_getc(int port);
+extern int serial_port_tstc(int port);
+extern void serial_port_drain(int port);
+extern int serial_port_set_baud(int port, unsigned int baud);
+extern unsigned int serial_port_get_baud(int port);
+extern int serial_port_baud_ok(int port, unsigned int baud);
+
+static u16 xm_crc_table[256];
+static u32 xm_tb_khz;
+static u8 xm_packet[1024 + 5];
+static int xm_port = XM_CONSOLE;    /* the port transfers run on */
+static u32 xm_xfer_baud;            /* 0: the port's current rate */
+static u32 xm_console_baud;
+static xm_idle_t xm_idle;           /* run while waiting for a byte */
+static void *xm_idle_arg;
+
+/*
+ * CRC16-CCITT, polynomial 0x1021, initial value 0
+ */
+static void xm_crc_init(void)
+{
+    u32 i, j;
+    u16 crc;
+
+    if (xm_crc_table[1] != 0)
+        return;
+    for (i = 0; i < 256; i++) {
+        crc = i << 8;
+        for (j = 0; j < 8; j++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        xm_crc_table[i] = crc;
+    }
+}
+
+FAST_FUNC static u16 xm_crc16(const u8 *p, u32 len)
+{
+    u16 crc = 0;
+
+    while (len--)
+        crc = (crc << 8) ^ xm_crc_table[(crc >> 8) ^ *p++];
+    return crc;
+}
+
+/*
+ * Line
+ */
+static int xm_port_getc_timeout(int port, u32 ms)
+{
+    u32 t0 = sysTimeBaseLGet();
+    u32 ticks = ms * xm_tb_khz;
+
+    while (!serial_port_tstc(port)) {
+        if (xm_idle != NULL)
+            xm_idle(xm_idle_arg);
+        if (sysTimeBaseLGet() - t0 >= ticks)
+            return XM_TIMEOUT;
+    }
+    return (u8)serial_port_getc(port);
+}
+
+static int xm_getc_timeout(u32 ms)
+{
+    return xm_port_getc_timeout(xm_port, ms);
+}
+
+static void xm_putc(u8 c)
+{
+    serial_port_putc(xm_port, c);
+}
+
+/* wait until the line has been quiet for a second */
+static void xm_purge(void)
+{
+    while (xm_getc_timeout(XM_BYTE_MS) != XM_TIMEOUT)
+        ;
+}
+
+static void xm_cancel(void)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        xm_putc(CAN);
+    xm_purge();
+}
+
+static void xm_timer_init(void)
+{
+    xm_tb_khz = sysTimeBaseFreqGet() / 1000;
+    xm_crc_init();
+}
+
+static u32 xm_elapsed_ms(u32 t0)
+{
+    u32 ms = (sysTimeBaseLGet() - t0) / xm_tb_khz;
+
+    return ms ? ms : 1;
+}
+
+/*
+ * Receive one packet into xm_packet[3...]
+ *
+ * Returns the data length, or XM_TIMEOUT/XM_ERROR/XM_EOT/XM_CANCEL.
+ */
+static int xm_recv_packet(int *blk, u32 ms)
+{
+    int c, len, i;
+    u16 crc;
+
+    c = xm_getc_timeout(ms);
+    switch (c) {
+    case SOH:
+        len = 128;
+        break;
+    case STX:
+        len = 1024;
+        break;
+    case EOT:
+        return XM_EOT;
+    case CAN:
+        return (xm_getc_timeout(XM_BYTE_MS) == CAN) ? XM_CANCEL : XM_ERROR;
+    case XM_TIMEOUT:
+        return XM_TIMEOUT;
+    default:
+        return XM_ERROR;
+    }
+
+    for (i = 1; i < len + 5; i++) {
+        if ((c = xm_getc_timeout(XM_BYTE_MS)) < 0)
+            return XM_TIMEOUT;
+        xm_packet[i] = c;
+    }
+    if ((xm_packet[1] ^ xm_packet[2]) != 0xff)
+        return XM_ERROR;
+    crc = (xm_packet[len + 3] << 8) | xm_packet[len + 4];
+    if (xm_crc16(xm_packet + 3, len) != crc)
+        return XM_ERROR;
+
+    *blk = xm_packet[1];
+    return len;
+}
+
+static void xm_send_packet(u8 blk, const u8 *data, u32 len, u32 size)
+{
+    u16 crc;
+    u32 i;
+
+    memcpy(xm_packet + 3, data, len);
+    memset(xm_packet + 3 + len, (blk == 0) ? 0 : CPMEOF, size - len);
+    xm_packet[0] = (size == 1024) ? STX : SOH;
+    xm_packet[1] = blk;
+    xm_packet[2] = ~blk;
+    crc = xm_crc16(xm_packet + 3, size);
+    xm_packet[size + 3] = crc >> 8;
+    xm_packet[size + 4] = crc & 0xff;
+    for (i = 0; i < size + 5; i++)
+        xm_putc(xm_packet[i]);
+}
+
+/*
+ * Receive one file, YMODEM-1K or XMODEM-CRC
+ *
+ * Each block is passed to sink before it is acknowledged, so the sink
+ * may take its time (e.g. to program flash).  A YMODEM batch is told
+ * from XMODEM by its block 0.  size limits the file, 0 means no limit.
+ * Returns the file length, or -1.
+ */
+static long xm_receive(xm_sink_t sink, void *arg, u32 size)
+{
+    u32 total = 0, file_size = 0, expect = 1;
+    int tries, errors = 0, len, blk, batch = 0;
+    const u8 *p;
+
+    xm_timer_init();
+
+    /* YMODEM block 0 with the file name and size, or XMODEM block 1 */
+    for (tries = 0; ; tries++) {
+        if (tries == XM_START_TRIES)
+            return -1;
+        xm_putc('C');
+        len = xm_recv_packet(&blk, XM_BYTE_MS);
+        if (len == XM_CANCEL)
+            return -1;
+        if (len > 0 && (blk == 0 || blk == 1))
+            break;
+        if (len != XM_TIMEOUT)
+            xm_purge();
+    }
+
+    if (blk == 0) {
+        batch = 1;
+        p = xm_packet + 3;
+        if (*p == '\0') {       /* empty batch */
+            xm_putc(ACK);
+            return -1;
+        }
+        p += strlen((const char *)p) + 1;
+        file_size = strtoul((const char *)p, NULL, 10);
+        if (size != 0 && file_size > size) {
+            xm_cancel();
+            return -1;
+        }
+        xm_putc(ACK);
+        xm_putc('C');
+        len = xm_recv_packet(&blk, XM_PACKET_MS);
+    }
+
+    for (;;) {
+        if (len == XM_CANCEL)
+            return -1;
+        if (len == XM_EOT) {
+            xm_putc(ACK);
+            break;
+        }
+        if (len < 0) {
+            if (++errors > XM_RETRIES) {
+                xm_cancel();
+                return -1;
+            }
+            xm_purge();
+            xm_putc(NAK);
+        } else if (blk == (expect & 0xff)) {
+            /* drop the padding of the last block */
+            if (file_size != 0 && total + len > file_size)
+                len = file_size - total;
+            if (size != 0 && total + len > size) {
+                if (total >= size) {
+                    xm_cancel();
+                    return -1;
+                }
+                len = size - total;
+            }
+            if (len > 0 && sink(arg, total, xm_packet + 3, len) < 0) {
+                xm_cancel();
+                return -1;
+            }
+            total += len;
+            expect++;
+            errors = 0;
+            xm_putc(ACK);
+        } else if (blk == ((expect - 1) & 0xff)) {
+            xm_putc(ACK);       /* our ACK was lost, the block is repeated */
+        } else {
+            xm_cancel();
+            return -1;
+        }
+        len = xm_recv_packet(&blk, XM_PACKET_MS);
+    }
+
+    /* the end of a batch is an empty block 0 */
+    for (tries = 0; batch && tries < XM_RETRIES; tries++) {
+        xm_putc('C');
+        len = xm_recv_packet(&blk, XM_BYTE_MS);
+        if (len > 0 && blk == 0) {
+            if (xm_packet[3] == '\0')
+                xm_putc(ACK);
+            else
+                xm_cancel();    /* only one file is taken */
+            break;
+        }
+        if (len == XM_CANCEL)
+            break;
+    }
+
+    return total;
+}
+
+static int xm_ram_sink(void *arg, u32 ofs, const u8 *data, u32 len)
+{
+    memcpy((char *)arg + ofs, data, len);
+    return 0;
+}
+
+
+/* the start character of the receiver, 'C' or 'G' */
+static int xm_wait_start(void)
+{
+    int tries, c;
+
+    for (tries = 0; tries < XM_START_TRIES; tries++) {
+        c = xm_getc_timeout(XM_BYTE_MS);
+        if (c == 'C' || c == 'G')
+            return c;
+        if (c == CAN && xm_getc_timeout(XM_BYTE_MS) == CAN)
+            return XM_CANCEL;
+    }
+    return XM_TIMEOUT;
+}
+
+/* send a packet until it is ACKed, returns 0 or -1 */
+static int xm_send_acked(u8 blk, const u8 *data, u32 len, u32 size)
+{
+    int tries, c;
+
+    for (tries = 0; tries < XM_RETRIES; tries++) {
+        xm_send_packet(blk, data, len, size);
+        c = xm_getc_timeout(XM_PACKET_MS);
+        if (c == ACK)
+            return 0;
+        if (c == CAN && xm_getc_timeout(XM_BYTE_MS) == CAN)
+            return -1;
+    }
+    return -1;
+}
+
+/*
+ * Send buf as a batch of one file, returns 0 or -1
+ */
+static int xm_send(const char *buf, u32 len, const char *name)
+{
+    u8 hdr[128];
+    u32 ofs, n, size;
+    int mode, tries, c;
+    u8 blk;
+
+    xm_timer_init();
+
+    memset(hdr, 0, sizeof(hdr));
+    strncpy((char *)hdr, name, XM_NAME_MAX);
+    sprintf((char *)hdr + strlen((char *)hdr) + 1, "%d", len);
+
+    if ((mode = xm_wait_start()) < 0)
+        return -1;
+    if (mode == 'G')
+        xm_send_packet(0, hdr, sizeof(hdr), 128);
+    else if (xm_send_acked(0, hdr, sizeof(hdr), 128) < 0)
+        return -1;
+
+    if ((mode = xm_wait_start()) < 0)
+        return -1;
+    for (ofs = 0, blk = 1; ofs < len; ofs += n, blk++) {
+        n = (len - ofs < 1024) ? len - ofs : 1024;
+        size = (n > 128) ? 1024 : 128;
+        if (mode == 'G') {
+            /* no turnaround: only look for a cancel between blocks */
+            xm_send_packet(blk, (const u8 *)buf + ofs, n, size);
+            if (serial_port_tstc(xm_port) && (u8)serial_port_getc(xm_port) == CAN)
+                return -1;
+        } else if (xm_send_acked(blk, (const u8 *)buf + ofs, n, size) < 0) {
+            xm_cancel();
+            return -1;
+        }
+    }
+
+    for (tries = 0; ; tries++) {
+        if (tries == XM_RETRIES)
+            return -1;
+        xm_putc(EOT);
+        c = xm_getc_timeout(XM_PACKET_MS);
+        if (c == ACK)
+            break;
+    }
+
+    /* end of batch */
+    memset(hdr, 0, sizeof(hdr));
+    if ((mode = xm_wait_start()) < 0)
+        return -1;
+    if (mode == 'G')
+        xm_send_packet(0, hdr, sizeof(hdr), 128);
+    else
+        (void)xm_send_acked(0, hdr, sizeof(hdr), 128);
+    return 0;
+}
+
+/*
+ * Transfers may run faster than the console, see "baud -x".  On another
+ * port the rate is just set, the console is switched back afterwards.
+ */
+static void xm_line_begin(void)
+{
+    xm_console_baud = serial_port_get_baud(XM_CONSOLE);
+    if (xm_xfer_baud == 0 || xm_xfer_baud == serial_port_get_baud(xm_port))
+        return;
+    if (xm_port == XM_CONSOLE)
+        printf("Switching to %d baud for the transfer\n", xm_xfer_baud);
+    serial_port_drain(xm_port);
+    (void)serial_port_set_baud(xm_port, xm_xfer_baud);
+}
+
+static void xm_line_end(void)
+{
+    if (serial_port_get_baud(XM_CONSOLE) == xm_console_baud)
+        return;
+    serial_port_drain(XM_CONSOLE);
+    (void)serial_port_set_baud(XM_CONSOLE, xm_console_baud);
+    printf("\nBack to %d baud\n", xm_console_baud);
+}
+
+/*
+ * xmodem_receive_to(): receive one file, blocks go to sink
+ *
+ * idle, if not NULL, is called while waiting for the line.  It must
+ * return within a few character times or the UART FIFO overruns.
+ */
+long xmodem_receive_to(xm_sink_t sink, xm_idle_t idle, void *arg, u32 size)
+{
+    long len;
+
+    xm_line_begin();
+    xm_idle = idle;
+    xm_idle_arg = arg;
+    len = xm_receive(sink, arg, size);
+    xm_idle = NULL;
+    xm_line_end();
+    return len;
+}
+
+/*
+ * xmodem_receive(): receive one file into buf
+ */
+long xmodem_receive(char *buf, u32 size)
+{
+    return xmodem_receive_to(xm_ram_sink, NULL, buf, size);
+}
+
+/*
+ * ymodem_send(): send buf as a batch of one file
+ *
+ * Returns 0 or -1.
+ */
+int ymodem_send(const char *buf, u32 len, const char *name)
+{
+    int ret;
+
+    xm_line_begin();
+    ret = xm_send(buf, len, name);
+    xm_line_end();
+    return ret;
+}
+
+/*
+ * User commands
+ */
+
+/*
+ * vivi> upload <addr> <len> [<name>]
+ */
+static void command_upload(int argc, const char **argv)
+{
+    const char *buf;
+    u32 len, t0, ms;
+    const char *name = "upload.bin";
+
+    if (argc != 3 && argc != 4) {
+        printf("invalid 'upload' command: too few(many) arguments\n");
+        printf("Usage: upload <addr> <len> [<name>]\n");
+        cmd_status = -1;
+        return;
+    }
+    buf = (const char *)strtoul(argv[1], NULL, 0);
+    len = strtoul(argv[2], NULL, 0);
+    if (argc == 4)
+        name = argv[3];
+
+    printf("Sending %d bytes at 0x%08lx as '%s' using ymodem (1K, -g)\n",
+        len, buf, name);
+    printf("Start the ymodem receive now...\n");
+
+    xm_timer_init();
+    t0 = sysTimeBaseLGet();
+    if (ymodem_send(buf, len, name) < 0) {
+        printf("\nupload: transfer failed\n");
+        cmd_status = -1;
+        return;
+    }
+    ms = xm_elapsed_ms(t0);
+    printf("\nSent %d bytes in %d ms\n", len, ms);
+}
+
+USER_CMD(upload_cmd) = {
+    "upload",
+    command_upload,
+    NULL,
+    "upload <addr> <len> [<name>] \t-- Send memory using ymodem"
+};
+
+/*
+ * vivi> download <addr> [<max len>]
+ */
+static void command_download(int argc, const char **argv)
+{
+    char *buf;
+    size_t size = 0;
+    long len;
+
+    if (argc != 2 && argc != 3) {
+        printf("invalid 'download' command: too few(many) arguments\n");
+        printf("Usage: download <addr> [<max len>]\n");
+        cmd_status = -1;
+        return;
+    }
+    buf = (char *)strtoul(argv[1], NULL, 0);
+    if (argc == 3)
+        size = strtoul(argv[2], NULL, 0);
+
+    printf("Ready for downloading at 0x%08lx using xmodem or ymodem...\n", buf);
+    len = xmodem_receive(buf, size);
+    if (len < 0) {
+        printf("\ndownload: transfer failed\n");
+        cmd_status = -1;
+        return;
+    }
+    printf("\nDownloaded %d bytes at 0x%08lx\n", len, buf);
+}
+
+USER_CMD(download_cmd) = {
+    "download",
+    command_download,
+    NULL,
+    "download <addr> [<max len>] \t-- Receive to memory using x/ymodem"
+};
+
+/*
+ * vivi> baud
+ * vivi> baud <rate>
+ * vivi> baud -x <rate>
+ * vivi> baud -p <port>
+ */
+static void command_baud(int argc, const char **argv)
+{
+    u32 rate, old = serial_port_get_baud(XM_CONSOLE);
+    int secs = 0, c, port;
+
+    if (argc == 1) {
+        printf("console %d baud, transfers on port %d at %d baud\n", old, xm_port,
+            xm_xfer_baud ? xm_xfer_baud : serial_port_get_baud(xm_port));
+        return;
+    }
+    if (argc == 3 && strcmp(argv[1], "-p") == 0) {
+        port = strtoul(argv[2], NULL, 0);
+        if (!serial_port_present(port)) {
+            printf("baud: there is no serial port %d\n", port);
+            cmd_status = -1;
+            return;
+        }
+        xm_port = port;
+        return;
+    }
+    if (argc == 3 && strcmp(argv[1], "-x") == 0) {
+        rate = strtoul(argv[2], NULL, 0);
+        if (rate != 0 && !serial_port_baud_ok(xm_port, rate)) {
+            printf("baud: %d can not be made from the UART clock\n", rate);
+            cmd_status = -1;
+            return;
+        }
+        xm_xfer_baud = rate;
+        return;
+    }
+    if (argc != 2) {
+        printf("invalid 'baud' command: too few(many) arguments\n");
+        printf("Usage: baud [[-x] <rate>] | [-p <port>]\n");
+        cmd_status = -1;
+        return;
+    }
+
+    rate = strtoul(argv[1], NULL, 0);
+    if (!serial_port_baud_ok(XM_CONSOLE, rate)) {
+        printf("baud: %d can not be made from the UART clock\n", rate);
+        cmd_status = -1;
+        return;
+    }
+    if (rate == old)
+        return;
+
+    printf("Switch to %d baud and press ENTER within %d seconds...\n",
+        rate, XM_BAUD_CONFIRM);
+    xm_timer_init();
+    serial_port_drain(XM_CONSOLE);
+    (void)serial_port_set_baud(XM_CONSOLE, rate);
+
+    /* characters sent at the old rate arrive as garbage, skip them */
+    while (secs < XM_BAUD_CONFIRM) {
+        c = xm_port_getc_timeout(XM_CONSOLE, XM_BYTE_MS);
+        if (c == '\r' || c == '\n')
+            break;
+        if (c == XM_TIMEOUT)
+            secs++;
+    }
+
+    if (secs == XM_BAUD_CONFIRM) {
+        (void)serial_port_set_baud(XM_CONSOLE, old);
+        printf("No answer, back to %d baud\n", old);
+        cmd_status = -1;
+        return;
+    }
+    set_param_value("baudrate", rate);
+    printf("Baud rate is now %d\n", rate);
+}
+
+USER_CMD(baud_cmd) = {
+    "baud",
+    command_baud,
+    NULL,
+    "baud [[-x] <rate>] | [-p <port>] \t-- Console/transfer baud rate and port"
+};
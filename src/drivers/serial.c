@@ -23,27 +23,144 @@
 
 #include "ns16550.h"
 
-static NS16550_t console = 0;
+#define CONFIG_BAUDRATE	115200
+#define BAUD_MAX_ERROR	3	/* percent */
 
-int serial_init ( NS16550_t base, unsigned int clk)
+/*
+ * Port 0 is the console, the others (e.g. the second DUART channel)
+ * carry bulk data at their own rate without touching the console.
+ */
+#define SERIAL_MAX_PORTS	2
+#define SERIAL_CONSOLE		0
+
+struct serial_port {
+	NS16550_t regs;
+	unsigned int clk;
+	unsigned int baud;
+};
+
+static struct serial_port serial_ports[SERIAL_MAX_PORTS];
+
+/*
+ * Nearest divisor, clk / 8 / baud first so that clk + 8 * baud can not
+ * overflow.  Returns 0 if the rate can not be made within BAUD_MAX_ERROR.
+ */
+static int serial_divisor(unsigned int clk, unsigned int baud)
+{
+	unsigned int div, actual, diff;
+
+	if (baud == 0)
+		return 0;
+	div = (clk / 8 / baud + 1) / 2;
+	if (div == 0 || div > 0xffff)
+		return 0;
+	actual = clk / 16 / div;
+	diff = (actual > baud) ? actual - baud : baud - actual;
+	if (diff > baud / 100 * BAUD_MAX_ERROR)
+		return 0;
+	return div;
+}
+
+int
+serial_port_init(int port, NS16550_t base, unsigned int clk, unsigned int baud)
 {
+	struct serial_port *sp;
+	int clock_divisor = serial_divisor(clk, baud);
 
-	int clock_divisor = clk / 16 / 115200;
+	if (port < 0 || port >= SERIAL_MAX_PORTS)
+		return -1;
+	if (clock_divisor == 0)		/* the console must come up anyway */
+		clock_divisor = clk / 16 / baud;
 
-	console = base;
+	sp = &serial_ports[port];
+	sp->regs = base;
+	sp->clk = clk;
+	sp->baud = baud;
 
-	NS16550_init(console, clock_divisor);
+	NS16550_init(sp->regs, clock_divisor);
 
 	return (0);
 }
 
+/* port 0 is always there, it is the console */
+int
+serial_port_present(int port)
+{
+	return port >= 0 && port < SERIAL_MAX_PORTS &&
+		serial_ports[port].regs != 0;
+}
+
+/* wait until the last character has left the shift register */
+void
+serial_port_drain(int port)
+{
+	while ((serial_ports[port].regs->lsr & LSR_TEMT) == 0)
+		;
+}
+
+/*
+ * Switch a port to a new rate, the caller drains it first.
+ * Returns -1 if the rate can not be made from the UART clock.
+ */
+int
+serial_port_set_baud(int port, unsigned int baud)
+{
+	struct serial_port *sp = &serial_ports[port];
+	int clock_divisor = serial_divisor(sp->clk, baud);
+
+	if (clock_divisor == 0)
+		return -1;
+	sp->baud = baud;
+	NS16550_reinit(sp->regs, clock_divisor);
+	return 0;
+}
+
+int
+serial_port_baud_ok(int port, unsigned int baud)
+{
+	return serial_divisor(serial_ports[port].clk, baud) != 0;
+}
+
+unsigned int
+serial_port_get_baud(int port)
+{
+	return serial_ports[port].baud;
+}
+
+/* no '\n' translation, for binary transfers */
+void
+serial_port_putc(int port, const char c)
+{
+	NS16550_putc(serial_ports[port].regs, c);
+}
+
+int
+serial_port_getc(int port)
+{
+	return NS16550_getc(serial_ports[port].regs);
+}
+
+int
+serial_port_tstc(int port)
+{
+	return NS16550_tstc(serial_ports[port].regs);
+}
+
+/*
+ * Console
+ */
+int serial_init ( NS16550_t base, unsigned int clk)
+{
+	return serial_port_init(SERIAL_CONSOLE, base, clk, CONFIG_BAUDRATE);
+}
+
 void
 serial_putc(const char c)
 {
 	if (c == '\n')
-		NS16550_putc(console, '\r');
+		serial_port_putc(SERIAL_CONSOLE, '\r');
 
-	NS16550_putc(console, c);
+	serial_port_putc(SERIAL_CONSOLE, c);
 }
 
 void
@@ -58,21 +175,26 @@ serial_puts (const char *s)
 int
 serial_getc(void)
 {
-	return NS16550_getc(console);
+	return serial_port_getc(SERIAL_CONSOLE);
 }
 
 int
 serial_tstc(void)
 {
-	return NS16550_tstc(console);
+	return serial_port_tstc(SERIAL_CONSOLE);
 }
 
 void
 serial_setbrg (unsigned int clk)
 {
-	int clock_divisor = clk / 16 / 115200;
+	struct serial_port *sp = &serial_ports[SERIAL_CONSOLE];
+	int clock_divisor = serial_divisor(clk, sp->baud);
+
+	if (clock_divisor == 0)
+		clock_divisor = clk / 16 / sp->baud;
+	sp->clk = clk;
 
-	NS16550_reinit(console, clock_divisor);
+	NS16550_reinit(sp->regs, clock_divisor);
 }
 
 int getc (void)